@@ -0,0 +1,28 @@
+/*
+ * Application hooks of the uC/OS-II port, called by the kernel when the
+ * BSP is built with OS_APP_HOOKS_EN=1
+ */
+#include "includes.h"
+#include "cpu_account.h"
+#include "stack_watch.h"
+
+void App_TaskSwHook(void)
+{
+  cpu_account_switch();
+}
+
+void App_TimeTickHook(void)
+{
+  cpu_account_tick();
+}
+
+/* Runs whenever the CPU has nothing else to do */
+void App_TaskIdleHook(void)
+{
+  stack_watch_step();
+}
+
+void App_TaskCreateHook(OS_TCB *ptcb) { }
+void App_TaskDelHook(OS_TCB *ptcb)    { }
+void App_TaskStatHook(void)           { }
+void App_TCBInitHook(OS_TCB *ptcb)    { }
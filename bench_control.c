@@ -0,0 +1,221 @@
+// File: bench_control.c
+
+/*
+ * Benchmark of the control path: fixed point against float PID, velocity
+ * update and plant step, and the track segment lookup of VehicleTask.
+ *
+ * Both implementations are fed the same pseudo random inputs; the program
+ * reports the time per call in ns and in timestamp ticks (CPU cycles on a
+ * board whose timestamp timer runs at the CPU clock) and the largest
+ * difference of the results.  Build with -DCRUISE_FLOAT_REFERENCE=1 so
+ * that the float implementation is compiled next to the fixed point one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "includes.h"
+#include "system.h"
+#include "sys/alt_timestamp.h"
+#include "pid.h"
+#include "vehicle.h"
+#include "track.h"
+
+#if !CRUISE_FLOAT_REFERENCE
+#error "bench_control.c needs CRUISE_FLOAT_REFERENCE=1"
+#endif
+
+#define BENCH_CALLS  1000000
+#define PID_RUN      100        /* PID steps between two resets */
+
+/* Inputs in the ranges of the application */
+static INT16U bench_target[BENCH_CALLS];
+static INT16U bench_velocity[BENCH_CALLS];
+static INT16S bench_vel16[BENCH_CALLS];
+static INT8S  bench_accel[BENCH_CALLS];
+static INT32U bench_position[BENCH_CALLS];
+
+volatile INT32S bench_sink;
+
+static INT32U bench_rand(void)
+{
+  static INT32U state = 12345;
+
+  state = state * 1103515245 + 12345;
+  return state >> 8;
+}
+
+static void bench_fill(void)
+{
+  int i;
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    bench_target[i] = 200 + bench_rand() % 500;   /* 20.0 .. 70.0 m/s */
+    bench_velocity[i] = bench_rand() % 700;       /*  0.0 .. 70.0 m/s */
+    bench_vel16[i] = (INT16S) (bench_rand() % 900) - 200;
+    bench_accel[i] = (INT8S) (bench_rand() % 61) - 20;
+    bench_position[i] = bench_rand() % track_length;
+  }
+}
+
+static void bench_report(const char *name, alt_timestamp_type t)
+{
+  printf("%-24s %8.1f ns/call %9.1f ticks/call\n", name,
+         (double) t * 1e9 / alt_timestamp_freq() / BENCH_CALLS,
+         (double) t / BENCH_CALLS);
+}
+
+static alt_timestamp_type bench_pid_fixed(void)
+{
+  struct _pid p;
+  alt_timestamp_type t0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++) {
+    if (i % PID_RUN == 0)
+      PID_init_fixed(&p);
+    sum += PID_realize_fixed(&p, bench_target[i], bench_velocity[i]);
+  }
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+static alt_timestamp_type bench_pid_float(void)
+{
+  struct _pid_float p;
+  alt_timestamp_type t0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++) {
+    if (i % PID_RUN == 0)
+      PID_init_float(&p);
+    sum += PID_realize_float(&p, bench_target[i], bench_velocity[i]);
+  }
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+static alt_timestamp_type bench_velocity_fixed(void)
+{
+  alt_timestamp_type t0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++)
+    sum += adjust_velocity(bench_vel16[i], bench_accel[i], off, 300);
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+static alt_timestamp_type bench_velocity_float(void)
+{
+  alt_timestamp_type t0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++)
+    sum += adjust_velocity_float(bench_vel16[i], bench_accel[i], off, 300);
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+/* Driving along the track at 50 m/s: the hint is nearly always right */
+static alt_timestamp_type bench_track_drive(void)
+{
+  alt_timestamp_type t0;
+  INT32U position = 0;
+  INT16U segment = 0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++) {
+    position = adjust_position(position, 500, 0, 300);
+    segment = track_find(position, segment);
+    sum += track[segment].slope;
+  }
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+/* Random positions: binary search */
+static alt_timestamp_type bench_track_random(void)
+{
+  alt_timestamp_type t0;
+  INT16U segment = 0;
+  INT32S sum = 0;
+  int i;
+
+  t0 = alt_timestamp();
+  for (i = 0; i < BENCH_CALLS; i++) {
+    segment = track_find(bench_position[i], segment);
+    sum += track[segment].slope;
+  }
+  bench_sink = sum;
+  return alt_timestamp() - t0;
+}
+
+/* Largest difference of the results of the two implementations */
+static void bench_compare(void)
+{
+  struct _pid pf;
+  struct _pid_float pd;
+  struct vehicle_plant qf, qd;
+  INT16S a, b;
+  int i, pid_max = 0, pid_diff = 0, vel_diff = 0, plant_diff = 0;
+
+  for (i = 0; i < BENCH_CALLS; i++) {
+    if (i % PID_RUN == 0) {
+      PID_init_fixed(&pf);
+      PID_init_float(&pd);
+    }
+    a = PID_realize_fixed(&pf, bench_target[i], bench_velocity[i]);
+    b = PID_realize_float(&pd, bench_target[i], bench_velocity[i]);
+    if (abs(a - b) > pid_max)
+      pid_max = abs(a - b);
+    if (a != b)
+      pid_diff++;
+
+    a = adjust_velocity(bench_vel16[i], bench_accel[i], off, 300);
+    b = adjust_velocity_float(bench_vel16[i], bench_accel[i], off, 300);
+    if (a != b)
+      vel_diff++;
+
+    qf = qd = (struct vehicle_plant) { bench_position[i], bench_vel16[i] };
+    vehicle_plant_step(&qf, bench_accel[i], off, 300);
+    vehicle_plant_step_float(&qd, bench_accel[i], off, 300);
+    if (memcmp(&qf, &qd, sizeof(qf)) != 0)
+      plant_diff++;
+  }
+  printf("PID: %d of %d outputs differ, max difference %d\n",
+         pid_diff, BENCH_CALLS, pid_max);
+  printf("adjust_velocity: %d of %d outputs differ\n", vel_diff, BENCH_CALLS);
+  printf("vehicle_plant_step: %d of %d states differ\n", plant_diff,
+         BENCH_CALLS);
+}
+
+int main(void)
+{
+  printf("Control path benchmark, %d calls, Q%d gains\n",
+         BENCH_CALLS, PID_FRAC_BITS);
+  bench_fill();
+  alt_timestamp_start();
+  printf("Timestamp timer at %lu Hz\n", (unsigned long) alt_timestamp_freq());
+
+  bench_report("PID_realize (float)", bench_pid_float());
+  bench_report("PID_realize (fixed)", bench_pid_fixed());
+  bench_report("adjust_velocity (float)", bench_velocity_float());
+  bench_report("adjust_velocity (fixed)", bench_velocity_fixed());
+  printf("Track of %d segments, %lu m\n", track_segments,
+         (unsigned long) track_length / 10);
+  bench_report("track_find (driving)", bench_track_drive());
+  bench_report("track_find (random)", bench_track_random());
+  bench_compare();
+  return 0;
+}
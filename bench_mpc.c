@@ -0,0 +1,94 @@
+// File: bench_mpc.c
+
+/*
+ * Benchmark of the look-ahead controller: CPU time of mpc_solve() against
+ * the control period.
+ *
+ * For each horizon the controller holds 30 m/s over two laps of the
+ * track, with the plant stepped by CONTROL_PERIOD, and each solve is
+ * timed with the timestamp timer.  The table gives the mean and largest
+ * time of a solve, the largest number of iterations and plant steps of a
+ * solve, and the bound of the solver (mpc_bound) times the mean cost of a
+ * plant step, each as a share of CONTROL_PERIOD.  The timestamp ticks are
+ * CPU cycles on a board whose timestamp timer runs at the CPU clock, so
+ * run there the table gives the cost at the target clock.
+ */
+
+#include <stdio.h>
+#include "includes.h"
+#include "system.h"
+#include "sys/alt_timestamp.h"
+#include "mpc.h"
+#include "track.h"
+
+#define BENCH_TARGET 300        /* 0.1 m/s */
+
+static const INT8U bench_horizon[] = { 8, 12, 20, 40, 80 };
+#define BENCH_HORIZONS (sizeof(bench_horizon) / sizeof(bench_horizon[0]))
+
+static struct mpc bench_mpc;
+
+static void bench_run(INT8U horizon)
+{
+  struct vehicle_plant p = { 0, BENCH_TARGET };
+  alt_timestamp_type t0, t, t_sum = 0, t_max = 0;
+  double budget = (double) alt_timestamp_freq() * CONTROL_PERIOD / 1000;
+  double per_step;
+  INT32U solves = 0, steps = 0, steps_max = 0, driven = 0, last;
+  INT16U segment = track_find(0, 0), it_max = 0;
+  INT8U throttle;
+
+  if (mpc_init(&bench_mpc, horizon, MPC_BLOCKS, 0) != 0) {
+    printf("%7d   not a multiple of %d blocks\n", horizon, MPC_BLOCKS);
+    return;
+  }
+  while (driven < 2 * track_length) {
+    t0 = alt_timestamp();
+    throttle = mpc_solve(&bench_mpc, p.position, p.velocity, BENCH_TARGET,
+                         NULL);
+    t = alt_timestamp() - t0;
+    t_sum += t;
+    if (t > t_max)
+      t_max = t;
+    solves++;
+    steps += bench_mpc.steps;
+    if (bench_mpc.steps > steps_max)
+      steps_max = bench_mpc.steps;
+    if (bench_mpc.iterations > it_max)
+      it_max = bench_mpc.iterations;
+
+    last = p.position;
+    vehicle_plant_step(&p, vehicle_acceleration(&p, throttle,
+                                                track[segment].slope),
+                       off, CONTROL_PERIOD);
+    segment = track_find(p.position, segment);
+    driven += p.position >= last ? p.position - last :
+                                   p.position + track_length - last;
+  }
+  per_step = (double) t_sum / steps;
+  printf("%7d %9.0f %9.0f %7.3f %5d %7lu %7lu %7.3f\n", horizon,
+         (double) t_sum / solves, (double) t_max, 100 * t_max / budget,
+         it_max, (unsigned long) steps_max,
+         (unsigned long) mpc_bound(&bench_mpc),
+         100 * per_step * mpc_bound(&bench_mpc) / budget);
+}
+
+int main(void)
+{
+  unsigned i;
+
+  printf("Look-ahead controller benchmark, %d blocks, at most %d iterations, "
+         "%d ms control period\n", MPC_BLOCKS, MPC_ITERATIONS, CONTROL_PERIOD);
+  printf("Timestamp timer %lu Hz, track of %lu m\n",
+         (unsigned long) alt_timestamp_freq(),
+         (unsigned long) track_length / 10);
+  alt_timestamp_start();
+
+  printf("\n%7s %9s %9s %7s %5s %7s %7s %7s\n", "horizon", "ticks",
+         "max", "max_%", "iter", "steps", "bound", "bound_%");
+  for (i = 0; i < BENCH_HORIZONS; i++)
+    bench_run(bench_horizon[i]);
+  printf("\nticks per solve; %% of the control period; steps are plant "
+         "steps\n");
+  return 0;
+}
@@ -0,0 +1,201 @@
+// File: bench_plant.c
+
+/*
+ * Benchmark of the vehicle model: accuracy against cost of the plant
+ * integrators of vehicle.c.
+ *
+ * A reference drives the continuous model (half the throttle less the
+ * wind, the rolling resistance and the slope) along the track in double
+ * precision with RK4 steps of 1 ms.  Its throttle is a pseudo random
+ * walk, changed every VEHICLE_PERIOD and kept even so that the legacy
+ * model, which halves it in integers, sees the same force.  The legacy
+ * model (vehicle_plant_step) and each Q8 method with 1 to 16 sub-steps
+ * then drive the same throttle sequence; after each period their state
+ * is compared with the reference.  The table gives the time per period
+ * (timestamp ticks are CPU cycles on a board whose timestamp timer runs
+ * at the CPU clock), the largest and RMS velocity error and the largest
+ * position error.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "includes.h"
+#include "system.h"
+#include "sys/alt_timestamp.h"
+#include "vehicle.h"
+#include "track.h"
+
+#define BENCH_STEPS  2000       /* 10 min at VEHICLE_PERIOD 300 ms */
+#define BENCH_REPEAT 100        /* Drives timed per model */
+#define BENCH_REF_MS 1          /* Step of the reference */
+#define BENCH_START  200        /* 20 m/s, 0.1 m/s */
+
+static INT8U  bench_throttle[BENCH_STEPS];
+static double bench_ref_x[BENCH_STEPS];  /* 0.1 m, not wrapped */
+static double bench_ref_v[BENCH_STEPS];  /* 0.1 m/s */
+
+volatile INT32S bench_sink;
+
+static INT32U bench_rand(void)
+{
+  static INT32U state = 12345;
+
+  state = state * 1103515245 + 12345;
+  return state >> 8;
+}
+
+static double bench_accel(double x, double v, INT8U throttle)
+{
+  INT16U segment = track_find((INT32U) fmod(x, track_length), 0);
+
+  return throttle / 2.0 - (v < 0 ? -v * v : v * v) / VEHICLE_WIND_DIV -
+         VEHICLE_ROLLING - track[segment].slope;
+}
+
+/* The throttle walks between 20 and 80 and leans to about 30 m/s */
+static void bench_reference(void)
+{
+  double x = 0, v = BENCH_START, h = BENCH_REF_MS / 1000.0;
+  double k1, k2, k3, k4;
+  int throttle = 50, i, ms;
+
+  for (i = 0; i < BENCH_STEPS; i++) {
+    throttle += (int) (bench_rand() % 9) - 4 + (v < 300 ? 1 : -1);
+    throttle = throttle < 20 ? 20 : throttle > 80 ? 80 : throttle;
+    bench_throttle[i] = (INT8U) (throttle & ~1);
+    for (ms = 0; ms < VEHICLE_PERIOD; ms += BENCH_REF_MS) {
+      k1 = bench_accel(x, v, bench_throttle[i]);
+      k2 = bench_accel(x + v * h / 2, v + k1 * h / 2, bench_throttle[i]);
+      k3 = bench_accel(x + (v + k1 * h / 2) * h / 2, v + k2 * h / 2,
+                       bench_throttle[i]);
+      k4 = bench_accel(x + (v + k2 * h / 2) * h, v + k3 * h,
+                       bench_throttle[i]);
+      x += (v + (v + k1 * h / 2) * 2 + (v + k2 * h / 2) * 2 +
+            (v + k3 * h)) / 6 * h;
+      v += (k1 + 2 * k2 + 2 * k3 + k4) / 6 * h;
+    }
+    bench_ref_x[i] = x;
+    bench_ref_v[i] = v;
+  }
+}
+
+struct bench_error {
+  double v_max;         /* m/s */
+  double v_sum2;
+  double x_max;         /* m */
+};
+
+static void bench_error_add(struct bench_error *e, int i, double position,
+                            double velocity)
+{
+  double dx, dv = fabs(velocity - bench_ref_v[i]) / 10;
+
+  /* Position on the track, the shorter way round */
+  dx = fabs(position - fmod(bench_ref_x[i], track_length));
+  if (dx > track_length / 2.0)
+    dx = track_length - dx;
+  dx /= 10;
+  if (dv > e->v_max)
+    e->v_max = dv;
+  if (dx > e->x_max)
+    e->x_max = dx;
+  e->v_sum2 += dv * dv;
+}
+
+static void bench_report(const char *name, int substeps, alt_timestamp_type t,
+                         const struct bench_error *e)
+{
+  double ticks = (double) t / BENCH_REPEAT / BENCH_STEPS;
+
+  printf("%-16s %3d %9.1f %9.0f %9.4f %9.4f %9.2f\n", name, substeps,
+         ticks * 1e9 / alt_timestamp_freq(), ticks, e->v_max,
+         sqrt(e->v_sum2 / BENCH_STEPS), e->x_max);
+}
+
+static void bench_legacy(void)
+{
+  struct vehicle_plant p;
+  struct bench_error e = { 0 };
+  alt_timestamp_type t0, t;
+  INT16U segment;
+  INT32S sum = 0;
+  int r, i;
+
+  t0 = alt_timestamp();
+  for (r = 0; r < BENCH_REPEAT; r++) {
+    p = (struct vehicle_plant) { 0, BENCH_START };
+    segment = track_find(0, 0);
+    for (i = 0; i < BENCH_STEPS; i++) {
+      vehicle_plant_step(&p, vehicle_acceleration(&p, bench_throttle[i],
+                                                  track[segment].slope),
+                         off, VEHICLE_PERIOD);
+      segment = track_find(p.position, segment);
+    }
+    sum += p.velocity;
+  }
+  t = alt_timestamp() - t0;
+  bench_sink = sum;
+
+  p = (struct vehicle_plant) { 0, BENCH_START };
+  segment = track_find(0, 0);
+  for (i = 0; i < BENCH_STEPS; i++) {
+    vehicle_plant_step(&p, vehicle_acceleration(&p, bench_throttle[i],
+                                                track[segment].slope),
+                       off, VEHICLE_PERIOD);
+    segment = track_find(p.position, segment);
+    bench_error_add(&e, i, p.position + p.position_frac / 1000.0,
+                    p.velocity + p.velocity_frac / 1000.0);
+  }
+  bench_report("legacy", 1, t, &e);
+}
+
+static void bench_q(const char *name, enum vehicle_method method,
+                    INT8U substeps)
+{
+  struct vehicle_integrator in = { method, substeps };
+  struct vehicle_q q;
+  struct bench_error e = { 0 };
+  alt_timestamp_type t0, t;
+  INT32S sum = 0;
+  int r, i;
+
+  t0 = alt_timestamp();
+  for (r = 0; r < BENCH_REPEAT; r++) {
+    q = (struct vehicle_q) { 0, BENCH_START * VEHICLE_Q_ONE };
+    for (i = 0; i < BENCH_STEPS; i++)
+      vehicle_integrate(&q, &in, bench_throttle[i], off, VEHICLE_PERIOD);
+    sum += q.velocity;
+  }
+  t = alt_timestamp() - t0;
+  bench_sink = sum;
+
+  q = (struct vehicle_q) { 0, BENCH_START * VEHICLE_Q_ONE };
+  for (i = 0; i < BENCH_STEPS; i++) {
+    vehicle_integrate(&q, &in, bench_throttle[i], off, VEHICLE_PERIOD);
+    bench_error_add(&e, i, q.position / (double) VEHICLE_Q_ONE,
+                    q.velocity / (double) VEHICLE_Q_ONE);
+  }
+  bench_report(name, substeps, t, &e);
+}
+
+int main(void)
+{
+  static const char *method[] = { "euler", "semi-implicit", "rk4" };
+  int m, n;
+
+  printf("Plant benchmark, %d periods of %d ms on a track of %lu m, "
+         "Q%d state\n", BENCH_STEPS, VEHICLE_PERIOD,
+         (unsigned long) track_length / 10, VEHICLE_Q_BITS);
+  bench_reference();
+  alt_timestamp_start();
+
+  printf("%-16s %3s %9s %9s %9s %9s %9s\n", "model", "n", "ns/step",
+         "ticks", "dv_max", "dv_rms", "dx_max");
+  bench_legacy();
+  for (m = VEHICLE_EULER; m <= VEHICLE_RK4; m++)
+    for (n = 1; n <= 16; n *= 2)
+      bench_q(method[m], (enum vehicle_method) m, (INT8U) n);
+  printf("dv in m/s, dx in m against a double RK4 at %d ms\n",
+         BENCH_REF_MS);
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include "cpu_account.h"
+#include "dump.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_timestamp.h"
+
+#if CRUISE_CPU_ACCOUNT
+
+struct cpu_slot {
+  const char *name;
+  alt_u64     total;            /* Timestamp cycles */
+  alt_u64     mark;             /* 'total' when the window opened */
+  INT32U      window[CPU_WINDOWS];      /* Cycles in each window */
+  INT32U      peak;             /* ppm */
+  INT16U      period;           /* ms of a job of a periodic task, or 0 */
+};
+
+static struct cpu_slot    cpu_slot[CPU_SLOTS];
+static INT32U             cpu_window_len[CPU_WINDOWS];  /* Cycles */
+static INT8U              cpu_window_next;      /* Window to close next */
+static INT8U              cpu_windows;          /* Windows closed, max CPU_WINDOWS */
+static alt_timestamp_type cpu_window_cycles;    /* One second */
+static alt_timestamp_type cpu_window_start;
+static alt_timestamp_type cpu_slice_start;      /* Of the running task or ISR */
+static INT32U             cpu_per_ms;           /* Timestamp cycles per ms */
+static INT8U              cpu_enabled;
+
+static const char *cpu_isr_name[CPU_ISR_NUM] = { "ISR alarm", "ISR input" };
+
+void cpu_account_init(void)
+{
+  INT8U id;
+
+  if (alt_timestamp_start() < 0) {
+    printf("No timestamp timer: CPU accounting disabled\n");
+    return;
+  }
+  cpu_per_ms = alt_timestamp_freq() / 1000;
+  cpu_window_cycles = alt_timestamp_freq();
+  for (id = 0; id < CPU_ISR_NUM; id++)
+    cpu_slot[CPU_SLOT_ISR(id)].name = cpu_isr_name[id];
+  cpu_window_start = cpu_slice_start = alt_timestamp();
+  cpu_enabled = 1;
+  dump_register(cpu_account_dump);
+}
+
+void cpu_account_name(INT8U slot, const char *name)
+{
+  if (slot < CPU_SLOTS)
+    cpu_slot[slot].name = name;
+}
+
+void cpu_account_period(INT8U slot, INT16U period_ms)
+{
+  if (slot < CPU_SLOTS)
+    cpu_slot[slot].period = period_ms;
+}
+
+/* Charges the time since the last charge to 'slot' */
+static alt_timestamp_type cpu_charge(INT8U slot)
+{
+  alt_timestamp_type now = alt_timestamp();
+
+  cpu_slot[slot].total += now - cpu_slice_start;
+  cpu_slice_start = now;
+  return now;
+}
+
+/* Closes the window at 'now', after all time up to 'now' was charged */
+static void cpu_window_close(alt_timestamp_type now)
+{
+  struct cpu_slot *s;
+  INT32U len, cycles, share;
+  INT8U slot;
+
+  len = (INT32U) (now - cpu_window_start);
+  cpu_window_start = now;
+  if (len == 0)
+    return;
+  for (slot = 0; slot < CPU_SLOTS; slot++) {
+    s = &cpu_slot[slot];
+    cycles = (INT32U) (s->total - s->mark);
+    s->mark = s->total;
+    s->window[cpu_window_next] = cycles;
+    share = (INT32U) ((alt_u64) cycles * 1000000 / len);
+    if (share > s->peak)
+      s->peak = share;
+  }
+  cpu_window_len[cpu_window_next] = len;
+  cpu_window_next = (cpu_window_next + 1) % CPU_WINDOWS;
+  if (cpu_windows < CPU_WINDOWS)
+    cpu_windows++;
+}
+
+/*
+ * Kernel hooks
+ */
+
+/* OSTCBCur is still the task that is switched out */
+void cpu_account_switch(void)
+{
+  alt_timestamp_type now;
+
+  if (cpu_enabled && OSTCBCur != NULL) {
+    now = cpu_charge(OSTCBCur->OSTCBPrio);
+    if (now - cpu_window_start >= cpu_window_cycles)
+      cpu_window_close(now);
+  }
+}
+
+/* Closes the window once a second of timestamp time has passed */
+void cpu_account_tick(void)
+{
+  if (cpu_enabled && OSTCBCur != NULL &&
+      alt_timestamp() - cpu_window_start >= cpu_window_cycles)
+    cpu_window_close(cpu_charge(OSTCBCur->OSTCBPrio));
+}
+
+/*
+ * Instrumentation of the ISRs
+ */
+void cpu_account_isr_enter(void)
+{
+  if (cpu_enabled && OSTCBCur != NULL)
+    cpu_charge(OSTCBCur->OSTCBPrio);
+}
+
+void cpu_account_isr_exit(INT8U id)
+{
+  if (cpu_enabled)
+    cpu_charge(CPU_SLOT_ISR(id));
+}
+
+/*
+ * Queries
+ */
+INT8U cpu_account_query(INT8U slot, struct cpu_usage *usage)
+{
+  struct cpu_slot *s;
+  alt_irq_context context;
+  alt_u64 cycles = 0, len = 0;
+  INT8U last, w;
+
+  if (slot >= CPU_SLOTS)
+    return OS_ERR_TASK_NOT_EXIST;
+  s = &cpu_slot[slot];
+  context = alt_irq_disable_all();
+  last = (cpu_window_next + CPU_WINDOWS - 1) % CPU_WINDOWS;
+  usage->last_1s = cpu_windows == 0 ? 0 :
+    (INT32U) ((alt_u64) s->window[last] * 1000000 / cpu_window_len[last]);
+  for (w = 0; w < cpu_windows; w++) {
+    cycles += s->window[w];
+    len    += cpu_window_len[w];
+  }
+  usage->last_10s = len == 0 ? 0 : (INT32U) (cycles * 1000000 / len);
+  usage->peak     = s->peak;
+  usage->total_ms = cpu_per_ms == 0 ? 0 : (INT32U) (s->total / cpu_per_ms);
+  alt_irq_enable_all(context);
+  return OS_NO_ERR;
+}
+
+/*
+ * Shares in percent; 'us/job' is the mean CPU time per period of a
+ * periodic task over the last CPU_WINDOWS seconds
+ */
+void cpu_account_dump(void)
+{
+  struct cpu_usage u;
+  INT8U slot;
+
+  printf("CPU [%%]               1s     10s    peak    us/job  total_ms\n");
+  for (slot = 0; slot < CPU_SLOTS; slot++) {
+    cpu_account_query(slot, &u);
+    if (cpu_slot[slot].name == NULL && u.total_ms == 0)
+      continue;
+    if (cpu_slot[slot].name != NULL)
+      printf("%-18s", cpu_slot[slot].name);
+    else
+      printf("prio %-13u", slot);
+    printf(" %3lu.%02lu  %3lu.%02lu  %3lu.%02lu",
+           (unsigned long) u.last_1s / 10000,
+           (unsigned long) u.last_1s / 100 % 100,
+           (unsigned long) u.last_10s / 10000,
+           (unsigned long) u.last_10s / 100 % 100,
+           (unsigned long) u.peak / 10000, (unsigned long) u.peak / 100 % 100);
+    if (cpu_slot[slot].period != 0)
+      printf(" %9lu", (unsigned long) u.last_10s * cpu_slot[slot].period
+             / 1000);
+    else
+      printf(" %9s", "-");
+    printf(" %9lu\n", (unsigned long) u.total_ms);
+  }
+}
+#endif
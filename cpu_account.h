@@ -0,0 +1,67 @@
+/*
+ * CPU time of each task and ISR
+ *
+ * The context switch hook of the kernel (App_TaskSwHook) charges the
+ * timestamp timer cycles since the last switch to the task that ran; the
+ * instrumented ISRs charge their own time between cpu_account_isr_enter()
+ * and cpu_account_isr_exit().  The switch and tick hooks close a window
+ * once the timestamp timer has moved on by a second since the last one
+ * (ticks that the kernel skips, as in virtual time, do not stretch it),
+ * which gives the share of the CPU of each task in the last second, the
+ * last CPU_WINDOWS seconds and the highest one second share seen.
+ * Anything not instrumented, e.g. the tick ISR itself, is charged to the
+ * task it interrupts.
+ *
+ * The BSP must be built with OS_APP_HOOKS_EN=1 (see app_hooks.c).
+ */
+#ifndef CPU_ACCOUNT_H_
+#define CPU_ACCOUNT_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+enum cpu_isr_id {
+  CPU_ISR_ALARM,        /* HW timer alarm of the SW timers */
+  CPU_ISR_INPUT,        /* Keys and switches */
+  CPU_ISR_NUM
+};
+
+/* Slots: one per task priority, then one per ISR */
+#define CPU_SLOT_ISR(id)  (OS_LOWEST_PRIO + 1 + (id))
+#define CPU_SLOTS         (OS_LOWEST_PRIO + 1 + CPU_ISR_NUM)
+
+#define CPU_WINDOWS       10    /* One second windows kept */
+
+struct cpu_usage {
+  INT32U last_1s;       /* Share of the CPU in ppm */
+  INT32U last_10s;      /* ppm, over up to CPU_WINDOWS windows */
+  INT32U peak;          /* Highest last_1s seen, ppm */
+  INT32U total_ms;      /* CPU time since the start */
+};
+
+#if CRUISE_CPU_ACCOUNT
+void  cpu_account_init(void);
+void  cpu_account_name(INT8U slot, const char *name);
+void  cpu_account_period(INT8U slot, INT16U period_ms);
+
+/* Called by the kernel hooks (app_hooks.c) */
+void  cpu_account_switch(void);
+void  cpu_account_tick(void);
+
+/* Instrumentation of ISRs, which must not nest */
+void  cpu_account_isr_enter(void);
+void  cpu_account_isr_exit(INT8U id);
+
+INT8U cpu_account_query(INT8U slot, struct cpu_usage *usage);
+void  cpu_account_dump(void);
+#else
+#define cpu_account_init()
+#define cpu_account_name(slot, name)
+#define cpu_account_period(slot, period_ms)
+#define cpu_account_switch()
+#define cpu_account_tick()
+#define cpu_account_isr_enter()
+#define cpu_account_isr_exit(id)
+#endif
+
+#endif /* CPU_ACCOUNT_H_ */
@@ -0,0 +1,148 @@
+#include <string.h>
+#include "cruise.h"
+#include "track.h"
+
+void cruise_vehicle_init(struct cruise_vehicle *v)
+{
+  memset(v, 0, sizeof(*v));
+  v->segment = track_find(0, 0);
+}
+
+void cruise_vehicle_set(struct cruise_vehicle *v, INT32U position,
+                        INT16S velocity)
+{
+  v->plant.position = position;
+  v->plant.velocity = velocity;
+  v->segment = track_find(position, 0);
+#if CRUISE_PLANT
+  v->q.position = (INT32S) position << VEHICLE_Q_BITS;
+  v->q.velocity = (INT32S) velocity << VEHICLE_Q_BITS;
+  v->q.segment = v->segment;
+#endif
+}
+
+void cruise_vehicle_step(struct cruise_vehicle *v, INT8U throttle,
+                         enum active brake_pedal, INT16U interval)
+{
+#if CRUISE_PLANT
+  struct vehicle_integrator integrator =
+    { (enum vehicle_method) (CRUISE_PLANT - 1), CRUISE_PLANT_SUBSTEPS,
+      v->drag, v->slope };
+
+  vehicle_integrate(&v->q, &integrator, throttle, brake_pedal, interval);
+  v->plant.position = VEHICLE_Q_POSITION(&v->q);
+  v->plant.velocity = VEHICLE_Q_VELOCITY(&v->q);
+#else
+  INT8S slope = v->slope != NULL ? v->slope[v->segment] :
+                                   track[v->segment].slope;
+
+  /* Retardation : Factor of Terrain and Wind Resistance */
+  vehicle_plant_step(&v->plant,
+                     v->drag != NULL ?
+                     vehicle_acceleration_drag(&v->plant, throttle, slope,
+                                               v->drag) :
+                     vehicle_acceleration(&v->plant, throttle, slope),
+                     brake_pedal, interval);
+#endif
+  v->segment = track_find(v->plant.position, v->segment);
+}
+
+void cruise_controller_init(struct cruise_controller *c)
+{
+  memset(c, 0, sizeof(*c));
+  c->engine = off;
+  c->gas_pedal = off;
+  c->brake_pedal = off;
+  c->top_gear = off;
+  c->cruise_control = off;
+#if CRUISE_CONTROLLER == 1
+  c->segment = track_find(0, 0);
+  PID_init_ff(&c->pid_ff);
+#elif CRUISE_CONTROLLER == 0
+  PID_init(&c->pid);
+#endif
+}
+
+INT8U cruise_controller_step(struct cruise_controller *c,
+                             const struct input_snapshot *in,
+                             INT32U position, INT16S velocity)
+{
+  INT16U steps;
+
+  /*
+   * Engine control
+   */
+  if(in->engine==on)
+    c->engine=on;
+  if(velocity==0&&in->engine==off)
+    c->engine=off;
+  if(c->engine==on)
+  {
+    /* One unit of throttle per PID_TUNED_PERIOD ms at any CONTROL_PERIOD */
+    c->ramp+=CONTROL_PERIOD;
+    steps=c->ramp/PID_TUNED_PERIOD;
+    c->ramp%=PID_TUNED_PERIOD;
+    if(c->gas_pedal==on)
+      c->throttle=c->throttle+steps>80 ? 80 : c->throttle+steps;
+    else if(c->cruise_control==off)
+      c->throttle=c->throttle>steps ? c->throttle-steps : 0;
+
+    /*
+     * Cruise control
+     */
+    if(velocity>=200&&in->cruise_button==on&&in->top_gear==on&&
+       in->gas_pedal==off&&in->brake_pedal==off)
+    {
+      c->cruise_control=on;
+      c->countercruise++;
+    }
+    else
+    {
+      c->cruise_control=off;
+      c->countercruise=0;
+    }
+    if(c->cruise_control==on&&c->countercruise==1)
+    {
+      c->target_vel=velocity;
+#if CRUISE_CONTROLLER == 1
+      PID_reset_fixed(&c->pid_ff);
+#elif CRUISE_CONTROLLER == 2
+      mpc_init(&c->mpc, MPC_HORIZON, MPC_BLOCKS, c->throttle);
+#endif
+    }
+    if(c->cruise_control==on)
+    {
+#if CRUISE_CONTROLLER == 1
+      /* The slope of the segment the vehicle is on */
+      c->segment=track_find(position, c->segment);
+      c->throttle=PID_throttle_ff(&c->pid_ff, c->target_vel, velocity,
+                                  vehicle_feedforward(c->target_vel,
+                                    c->slope!=NULL ? c->slope[c->segment] :
+                                                     track[c->segment].slope));
+#elif CRUISE_CONTROLLER == 2
+      c->throttle=mpc_solve(&c->mpc, position, velocity, c->target_vel,
+                           c->slope);
+#else
+      c->throttle=PID_throttle(PID_realize(&c->pid, c->target_vel, velocity));
+#endif
+    }
+    /*
+     * Gas Pedal, brake and gear
+     */
+    c->gas_pedal=in->gas_pedal;
+    if(c->gas_pedal==on)
+      c->cruise_control=off;
+    c->brake_pedal=in->brake_pedal;
+    if(c->brake_pedal==on)
+      c->cruise_control=off;
+    c->top_gear=in->top_gear;
+  }
+  else
+  {
+    if(c->cruise_control==off&&c->gas_pedal==off)
+      c->throttle=0;
+  }
+  if (c->throttle>80)
+    c->throttle=80;
+  return c->throttle;
+}
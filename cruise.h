@@ -0,0 +1,80 @@
+/*
+ * Instance context of one vehicle with its cruise control
+ *
+ * The state of VehicleTask (the plant) and of ControlTask (the inputs of
+ * the last cycle, the gas pedal ramp, the cruise control and its
+ * controller) lives in a struct cruise_vehicle and a struct
+ * cruise_controller, and the steps of the two tasks are functions of
+ * them.  Nothing in the steps is global or static, so any number of
+ * instances can be stepped, on any number of threads, as long as each is
+ * stepped by one thread at a time.  The tasks of cruise_skeleton.c own
+ * one of each; the host fleet runner (host/fleet_sim.c) thousands.  The
+ * host simulations (host/sim.c) step them with the drag and the slopes
+ * of their scenario.
+ */
+#ifndef CRUISE_H_
+#define CRUISE_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+#include "vehicle.h"
+#include "inputs.h"
+#include "pid.h"
+#include "mpc.h"
+
+struct cruise_vehicle {
+  struct vehicle_plant plant;   /* Position 0.1 m, velocity 0.1 m/s */
+#if CRUISE_PLANT
+  struct vehicle_q     q;
+#endif
+  INT16U               segment; /* Track segment at the position */
+  const struct vehicle_drag *drag;      /* NULL: the drag of the board */
+  const INT8S               *slope;     /* Of each segment, NULL: the track */
+};
+
+struct cruise_controller {
+  /* Inputs as of the last cycle */
+  enum active engine;
+  enum active gas_pedal;
+  enum active brake_pedal;
+  enum active top_gear;
+  /* Output */
+  enum active cruise_control;
+  INT8U       throttle;         /* 0.1 V, 0 to 80 */
+  INT16U      target_vel;       /* 0.1 m/s */
+  INT32U      countercruise;    /* Cycles the cruise control is on */
+  INT16U      ramp;             /* ms of gas pedal ramp not yet applied */
+#if CRUISE_CONTROLLER == 1
+  struct _pid pid_ff;
+  INT16U      segment;
+#elif CRUISE_CONTROLLER == 2
+  struct mpc  mpc;
+#endif
+#if CRUISE_CONTROLLER == 1 || CRUISE_CONTROLLER == 2
+  const INT8S *slope;           /* Of each segment, NULL: the track */
+#else
+  struct pid_state pid;
+#endif
+};
+
+void cruise_vehicle_init(struct cruise_vehicle *v);
+
+/* Puts the vehicle at 'position' with 'velocity' */
+void cruise_vehicle_set(struct cruise_vehicle *v, INT32U position,
+                        INT16S velocity);
+
+/* VehicleTask: 'interval' ms at 'throttle' */
+void cruise_vehicle_step(struct cruise_vehicle *v, INT8U throttle,
+                         enum active brake_pedal, INT16U interval);
+
+void cruise_controller_init(struct cruise_controller *c);
+
+/*
+ * ControlTask: one cycle with the inputs 'in' and the vehicle at
+ * 'position' and 'velocity'; returns the throttle
+ */
+INT8U cruise_controller_step(struct cruise_controller *c,
+                             const struct input_snapshot *in,
+                             INT32U position, INT16S velocity);
+
+#endif /* CRUISE_H_ */
@@ -0,0 +1,289 @@
+/*
+ * Build options of the cruise control application
+ *
+ * Every option can be overridden on the compiler command line (-D...).
+ */
+#ifndef CRUISE_CONFIG_H_
+#define CRUISE_CONFIG_H_
+
+/*
+ * Arithmetic of the control path (PID and vehicle model)
+ * 1: fixed point, no soft-float calls on a Nios II without FPU
+ * 0: float, the original implementation
+ */
+#ifndef CRUISE_FIXED_POINT
+#define CRUISE_FIXED_POINT 1
+#endif
+
+/*
+ * Also build the float implementation next to the fixed point one
+ * (needed by bench_control.c)
+ */
+#ifndef CRUISE_FLOAT_REFERENCE
+#define CRUISE_FLOAT_REFERENCE (!CRUISE_FIXED_POINT)
+#endif
+
+/*
+ * Rates in ms.  The SW timers tick every HW_TIMER_PERIOD (1 ms at the
+ * least) and release VehicleTask, ControlTask and ShowCPUUsage, whose
+ * periods must be multiples of it; e.g. -DHW_TIMER_PERIOD=10
+ * -DVEHICLE_PERIOD=10 -DCONTROL_PERIOD=50 runs the plant at 100 Hz and
+ * the controller at 20 Hz.  VehicleTask logs its state every
+ * LOG_STATE_PERIOD.
+ */
+#ifndef HW_TIMER_PERIOD
+#define HW_TIMER_PERIOD 100
+#endif
+#ifndef VEHICLE_PERIOD
+#define VEHICLE_PERIOD 300
+#endif
+#ifndef CONTROL_PERIOD
+#define CONTROL_PERIOD 300
+#endif
+#ifndef SHOWCPU_PERIOD
+#define SHOWCPU_PERIOD 500
+#endif
+#ifndef EXTRALOAD_PERIOD
+#define EXTRALOAD_PERIOD 300
+#endif
+#ifndef LOG_STATE_PERIOD
+#define LOG_STATE_PERIOD 300
+#endif
+
+/*
+ * Vehicle model of VehicleTask (vehicle.c)
+ * 0: whole units with the fractions carried over, as before
+ * 1: Q8 state, explicit Euler
+ * 2: Q8 state, semi-implicit Euler
+ * 3: Q8 state, RK4
+ * The Q8 integrators take CRUISE_PLANT_SUBSTEPS sub-steps per period;
+ * bench_plant.c compares their error and cost.
+ */
+#ifndef CRUISE_PLANT
+#define CRUISE_PLANT 0
+#endif
+#ifndef CRUISE_PLANT_SUBSTEPS
+#define CRUISE_PLANT_SUBSTEPS 1
+#endif
+
+/*
+ * Inputs of the keys and switches
+ * 1: edge capture interrupts post the changed bits to EngineStatus
+ *    (ButtonIOTask and SwitchIOTask are not built)
+ * 0: ButtonIOTask and SwitchIOTask poll the PIOs
+ */
+#ifndef CRUISE_INPUT_IRQ
+#define CRUISE_INPUT_IRQ 1
+#endif
+
+/*
+ * Lockout after an input edge: further edges within this time are
+ * treated as contact bounce and the state is sampled again at its end
+ */
+#ifndef INPUT_DEBOUNCE_MS
+#define INPUT_DEBOUNCE_MS 20
+#endif
+
+/*
+ * Logging of the periodic output (log.c)
+ * 1: binary records in a ring buffer, printed by LogTask when idle
+ * 0: printed at once by the task that logs
+ */
+#ifndef CRUISE_LOG
+#define CRUISE_LOG 1
+#endif
+
+/* Records in the ring buffer, a power of two */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 128
+#endif
+
+/* Period of LogTask in ms */
+#ifndef LOG_DRAIN_PERIOD
+#define LOG_DRAIN_PERIOD 50
+#endif
+
+/*
+ * Release, start and completion timestamps of the periodic tasks with
+ * histograms per task (task_timing.c); KEY0 prints them
+ */
+#ifndef CRUISE_TASK_TIMING
+#define CRUISE_TASK_TIMING 1
+#endif
+
+/*
+ * Response time of ControlTask in OS ticks, printed every
+ * CRUISE_CONTROL_TIMING cycles (0: not measured)
+ */
+#ifndef CRUISE_CONTROL_TIMING
+#define CRUISE_CONTROL_TIMING 0
+#endif
+
+/*
+ * CPU time of each task and ISR from the kernel hooks (cpu_account.c);
+ * KEY0 prints it.  Needs a BSP with OS_APP_HOOKS_EN=1.
+ */
+#ifndef CRUISE_CPU_ACCOUNT
+#define CRUISE_CPU_ACCOUNT 1
+#endif
+
+/*
+ * Stack high-watermarks of the tasks, scanned STACK_SCAN_WORDS words at a
+ * time by the idle hook (stack_watch.c); KEY0 prints them with proposed
+ * stack sizes: the peak plus STACK_MARGIN_PCT %, at least
+ * STACK_MARGIN_MIN words
+ */
+#ifndef CRUISE_STACK_WATCH
+#define CRUISE_STACK_WATCH 1
+#endif
+#ifndef STACK_SCAN_WORDS
+#define STACK_SCAN_WORDS 256
+#endif
+#ifndef STACK_MARGIN_PCT
+#define STACK_MARGIN_PCT 25
+#endif
+#ifndef STACK_MARGIN_MIN
+#define STACK_MARGIN_MIN 128
+#endif
+
+/*
+ * Stack sizes of the tasks in OS_STK words: a file of
+ * '#define <TASK>_STACKSIZE <words>' lines as printed by the stack
+ * report, e.g. "stack_sizes.h"; tasks not in it get TASK_STACKSIZE
+ */
+/* #define STACK_SIZES "stack_sizes.h" */
+
+/*
+ * Tickless mode: the alarm of the SW timers is a one-shot to the next
+ * timer expiry instead of every HW_TIMER_PERIOD ms, and the Watchdog
+ * sleeps until the next possible deadline miss.  This saves alarm
+ * callbacks and scans, not interrupts: the alarms run in the 1 ms OS tick
+ * of the board, which stays periodic.
+ */
+#ifndef CRUISE_TICKLESS
+#define CRUISE_TICKLESS 0
+#endif
+
+/*
+ * Period of DisplayTask in ms: the displays and LEDs that changed are
+ * written at this rate (display.c)
+ */
+#ifndef DISPLAY_PERIOD
+#define DISPLAY_PERIOD 50
+#endif
+
+/*
+ * Period of the deadline scan of the Watchdog task in ms (monitor.c); in
+ * tickless mode the Watchdog sleeps until the next possible miss instead
+ */
+#ifndef MONITOR_SCAN_PERIOD
+#define MONITOR_SCAN_PERIOD 10
+#endif
+
+/*
+ * Overload sweep of ExtraLoad: 0 takes the load from the switches SW4..9;
+ * otherwise the load is stepped from 0 to 100 % of the CPU in steps of
+ * CRUISE_LOAD_SWEEP % and held for LOAD_SWEEP_PERIODS periods each, then
+ * a table of the response times and deadline misses is printed (needs
+ * CRUISE_TASK_TIMING)
+ */
+#ifndef CRUISE_LOAD_SWEEP
+#define CRUISE_LOAD_SWEEP 0
+#endif
+#ifndef LOAD_SWEEP_PERIODS
+#define LOAD_SWEEP_PERIODS 20
+#endif
+
+/*
+ * Track profile (track.c): a file of TRACK_SEGMENT() lines and a
+ * TRACK_END(), e.g. "track_hills.def" for an 80 km route
+ */
+#ifndef TRACK_TABLE
+#define TRACK_TABLE "track_loop.def"
+#endif
+
+/*
+ * PID gains
+ */
+#ifndef PID_KP
+#define PID_KP 20
+#endif
+#ifndef PID_KI
+#define PID_KI 0.08
+#endif
+#ifndef PID_KD
+#define PID_KD 0.2
+#endif
+
+/*
+ * Controller of the cruise control
+ * 0: PID, its output squared to the throttle (PID_throttle)
+ * 1: feedforward of the slope of the current segment and the drag at the
+ *    target velocity (vehicle_feedforward), plus a fixed point PID
+ *    correction with the gains PID_FF_KP, PID_FF_KI and PID_FF_KD in
+ *    0.1 V of throttle per 0.1 m/s
+ * 2: look-ahead controller (mpc.c), which predicts the plant over the
+ *    slopes of the next MPC_HORIZON control periods
+ */
+#ifndef CRUISE_CONTROLLER
+#define CRUISE_CONTROLLER 0
+#endif
+#ifndef PID_FF_KP
+#define PID_FF_KP 2
+#endif
+#ifndef PID_FF_KI
+#define PID_FF_KI 0.1
+#endif
+#ifndef PID_FF_KD
+#define PID_FF_KD 0
+#endif
+
+/*
+ * Look-ahead controller: MPC_HORIZON control periods in MPC_BLOCKS
+ * blocks of constant throttle (at most MPC_BLOCKS_MAX), at most
+ * MPC_ITERATIONS iterations of the search with a first step of MPC_STEP
+ * (a power of two).  The cost weighs the squared velocity errors [0.1
+ * m/s] with MPC_Q (at most 64) and the squared throttle changes [0.1 V]
+ * with MPC_R.
+ */
+#ifndef MPC_HORIZON
+#define MPC_HORIZON 20
+#endif
+#ifndef MPC_BLOCKS
+#define MPC_BLOCKS 4
+#endif
+#define MPC_BLOCKS_MAX 8
+#ifndef MPC_ITERATIONS
+#define MPC_ITERATIONS 16
+#endif
+#ifndef MPC_STEP
+#define MPC_STEP 16
+#endif
+#ifndef MPC_Q
+#define MPC_Q 4
+#endif
+#ifndef MPC_R
+#define MPC_R 1
+#endif
+
+/*
+ * The gains are tuned per step of PID_TUNED_PERIOD ms; at another
+ * CONTROL_PERIOD the integral and derivative gains are scaled so the
+ * controller keeps its behaviour in time.  The gas pedal moves the
+ * throttle by one unit every PID_TUNED_PERIOD ms as well.
+ */
+#define PID_TUNED_PERIOD 300
+#define PID_KI_STEP (PID_KI * CONTROL_PERIOD / PID_TUNED_PERIOD)
+#define PID_KD_STEP (PID_KD * PID_TUNED_PERIOD / CONTROL_PERIOD)
+#define PID_FF_KI_STEP (PID_FF_KI * CONTROL_PERIOD / PID_TUNED_PERIOD)
+#define PID_FF_KD_STEP (PID_FF_KD * PID_TUNED_PERIOD / CONTROL_PERIOD)
+
+/*
+ * Fixed point gains have PID_FRAC_BITS fraction bits.  With 10 bits the
+ * gains resolve to 0.001 and Kp * err stays within 32 bits for every
+ * INT16S error.  PID_GAIN() is folded by the compiler.
+ */
+#define PID_FRAC_BITS 10
+#define PID_GAIN(k) ((INT32S) ((k) * (1 << PID_FRAC_BITS) + ((k) < 0 ? -0.5 : 0.5)))
+
+#endif /* CRUISE_CONFIG_H_ */
@@ -4,22 +4,46 @@
 #include "altera_avalon_pio_regs.h"
 #include "sys/alt_irq.h"
 #include "sys/alt_alarm.h"
-
-#define DEBUG 0
-
-#define HW_TIMER_PERIOD 100 /* 100ms */
+#include "vehicle.h"
+#include "cruise.h"
+#include "inputs.h"
+#include "vehicle_state.h"
+#include "log.h"
+#include "task_timing.h"
+#include "track.h"
+#include "load.h"
+#include "monitor.h"
+#include "cpu_account.h"
+#include "stack_watch.h"
+#include "display.h"
+#include "dump.h"
+
+#if CRUISE_LOAD_SWEEP && !CRUISE_TASK_TIMING
+#error "CRUISE_LOAD_SWEEP needs CRUISE_TASK_TIMING"
+#endif
+
+/* HW_TIMER_PERIOD and the task periods are set in cruise_config.h */
+#if HW_TIMER_PERIOD * OS_TICKS_PER_SEC < 1000
+#error "HW_TIMER_PERIOD is shorter than an OS tick"
+#endif
+#if CRUISE_CONTROLLER < 0 || CRUISE_CONTROLLER > 2
+#error "CRUISE_CONTROLLER is 0 to 2"
+#endif
+#if CRUISE_CONTROLLER == 2 && (MPC_HORIZON % MPC_BLOCKS || \
+    MPC_BLOCKS > MPC_BLOCKS_MAX || MPC_HORIZON > 255)
+#error "MPC_HORIZON must be a multiple of MPC_BLOCKS, at most 255"
+#endif
+#if CRUISE_PLANT < 0 || CRUISE_PLANT > 3 || CRUISE_PLANT_SUBSTEPS < 1
+#error "CRUISE_PLANT is 0 to 3 with at least 1 sub-step"
+#endif
+#if VEHICLE_PERIOD % HW_TIMER_PERIOD || CONTROL_PERIOD % HW_TIMER_PERIOD || \
+    SHOWCPU_PERIOD % HW_TIMER_PERIOD
+#error "The task periods must be multiples of HW_TIMER_PERIOD"
+#endif
 
 /*Flag Group*/
 OS_FLAG_GRP *EngineStatus;
-/* Button Patterns */
-
-#define GAS_PEDAL_FLAG      0x08
-#define BRAKE_PEDAL_FLAG    0x04
-#define CRUISE_CONTROL_FLAG 0x02
-/* Switch Patterns */
-
-#define TOP_GEAR_FLAG       0x00000010
-#define ENGINE_FLAG         0x00000001
+/* Button and Switch Patterns are defined in inputs.h */
 
 /* LED Patterns */
 
@@ -31,22 +55,70 @@ OS_FLAG_GRP *EngineStatus;
 #define LED_GREEN_4 0x0010 // Brake Pedal
 #define LED_GREEN_6 0x0040 // Gas Pedal
 
+/* LEDs of the switches and of the position (display.c) */
+#define LED_RED_SWITCHES   0x003ff
+#define LED_RED_POSITION   0xffc00
+#define LED_GREEN_KEYS     0xfe
+
 /*
  * Definition of Tasks
  */
 
 #define TASK_STACKSIZE 2048
 
-OS_STK StartTask_Stack[TASK_STACKSIZE]; 
-OS_STK ControlTask_Stack[TASK_STACKSIZE]; 
-OS_STK VehicleTask_Stack[TASK_STACKSIZE];
-OS_STK ButtonIOTask_Stack[TASK_STACKSIZE];
-OS_STK SwitchIOTask_Stack[TASK_STACKSIZE];
-OS_STK ExtraLoadTask_Stack[TASK_STACKSIZE];
-OS_STK WatchdogTask_Stack[TASK_STACKSIZE];
-OS_STK OverloadTask_Stack[TASK_STACKSIZE];
-OS_STK ShowCPUTask_Stack[TASK_STACKSIZE];
-OS_STK stat_stk[TASK_STACKSIZE];
+/* Stack sizes proposed by the stack report, see stack_watch.h */
+#ifdef STACK_SIZES
+#include STACK_SIZES
+#endif
+#ifndef STARTTASK_STACKSIZE
+#define STARTTASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef CONTROLTASK_STACKSIZE
+#define CONTROLTASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef VEHICLETASK_STACKSIZE
+#define VEHICLETASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef BUTTONIOTASK_STACKSIZE
+#define BUTTONIOTASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef SWITCHIOTASK_STACKSIZE
+#define SWITCHIOTASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef EXTRALOAD_STACKSIZE
+#define EXTRALOAD_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef WATCHDOG_STACKSIZE
+#define WATCHDOG_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef OVERLOADDETECTION_STACKSIZE
+#define OVERLOADDETECTION_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef SHOWCPUUSAGE_STACKSIZE
+#define SHOWCPUUSAGE_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef LOGTASK_STACKSIZE
+#define LOGTASK_STACKSIZE TASK_STACKSIZE
+#endif
+#ifndef DISPLAYTASK_STACKSIZE
+#define DISPLAYTASK_STACKSIZE TASK_STACKSIZE
+#endif
+
+OS_STK StartTask_Stack[STARTTASK_STACKSIZE]; 
+OS_STK ControlTask_Stack[CONTROLTASK_STACKSIZE]; 
+OS_STK VehicleTask_Stack[VEHICLETASK_STACKSIZE];
+#if !CRUISE_INPUT_IRQ
+OS_STK ButtonIOTask_Stack[BUTTONIOTASK_STACKSIZE];
+OS_STK SwitchIOTask_Stack[SWITCHIOTASK_STACKSIZE];
+#endif
+OS_STK ExtraLoadTask_Stack[EXTRALOAD_STACKSIZE];
+OS_STK WatchdogTask_Stack[WATCHDOG_STACKSIZE];
+OS_STK OverloadTask_Stack[OVERLOADDETECTION_STACKSIZE];
+OS_STK ShowCPUTask_Stack[SHOWCPUUSAGE_STACKSIZE];
+#if CRUISE_LOG
+OS_STK LogTask_Stack[LOGTASK_STACKSIZE];
+#endif
+OS_STK DisplayTask_Stack[DISPLAYTASK_STACKSIZE];
 
 // Task Priorities
  
@@ -55,29 +127,20 @@ OS_STK stat_stk[TASK_STACKSIZE];
 #define ShowCPUTASK_RPIO  7
 #define VEHICLETASK_PRIO  10
 #define CONTROLTASK_PRIO  12
+#define DISPLAYTASK_PRIO  13
 #define BUTTONTASK_PRIO  14
 #define SWITCHTASK_PRIO  15
 #define EXTRALOADTASK_PRIO 16
 #define OVERLOADTASK_RPIO 17
-#define TASK_STAT_PRIORITY 18
-
-// Task Periods
-
-#define CONTROL_PERIOD  300
-#define VEHICLE_PERIOD  300
+#define LOGTASK_PRIO      18  // lowest application priority
 
 /*
  * Definition of Kernel Objects 
  */
 
-// Mailboxes
-OS_EVENT *Mbox_Throttle;
-OS_EVENT *Mbox_Velocity;
-
 // Semaphores
 OS_EVENT *VehicleSem;
 OS_EVENT *ControlSem;
-OS_EVENT *OK;
 OS_EVENT *ShowCPUSem;
 
 // SW-Timer
@@ -85,66 +148,97 @@ OS_TMR *VehicleTmr;
 OS_TMR *ControlTmr;
 OS_TMR *ShowCPUTmr;
 
-/*
- * Types
- */
-enum active {on, off};
-
-enum active gas_pedal = off;
-enum active brake_pedal = off;
-enum active top_gear = off;
-enum active engine = off;
-enum active cruise_control = off; 
-
 /*
  * Global variables
  */
 int delay; // Delay of HW-timer 
-INT16U led_green = 0; // Green LEDs
-INT32U led_red = 0;   // Red LEDs
 
+#if CRUISE_TICKLESS
 /*
- * Debug
+ * Tickless mode: the alarm is due at the next expiry of a SW timer and
+ * gives all the 'ticks' of the SW timers since the last one at once.
+ * Timers started later are served at the next alarm at the latest.
+ *
+ * OS_TmrTask relinks the timers with interrupts enabled, so the alarm
+ * does not read them.  Their callbacks, which OS_TmrTask calls once the
+ * timer is relinked, copy the next expiry to alarm_timers[]; StartTask
+ * copies the first one with the scheduler locked.
  */
-void printStackSize(INT8U prio)
+struct alarm_timer {
+  OS_TMR **tmr;
+  INT32U   match;       /* OSTmrTime of the next expiry */
+  INT32U   period;      /* SW timer ticks, the timers are periodic */
+};
+
+static struct alarm_timer alarm_timers[] = {
+  { &VehicleTmr }, { &ControlTmr }, { &ShowCPUTmr }
+};
+static INT32U alarm_signals = 1;  /* SW timer ticks at the next alarm */
+static INT32U alarm_tmr_time;     /* OSTmrTime once they are processed */
+
+#define ALARM_TIMERS (sizeof(alarm_timers) / sizeof(alarm_timers[0]))
+
+/* Copies the next expiry of 'ptmr', which OS_TmrTask is not processing */
+static void alarm_timer_update(OS_TMR *ptmr)
 {
-    INT8U err;
-    OS_STK_DATA stk_data;
-    
-    err = OSTaskStkChk(prio, &stk_data);
-    if (err == OS_NO_ERR) 
-    {
-        if (DEBUG == 1)
-           printf("Task Priority %d - Used: %d; Free: %d\n", 
-                   prio, stk_data.OSFree, stk_data.OSUsed);
-    }
-    else
-    {
-        if (DEBUG == 1)
-           printf("Stack Check Error!\n");    
-    }
+  alt_irq_context context;
+  INT8U i;
+
+  for (i = 0; i < ALARM_TIMERS; i++) {
+    if (*alarm_timers[i].tmr != ptmr)
+      continue;
+    context = alt_irq_disable_all();
+    alarm_timers[i].match  = ptmr->OSTmrMatch;
+    alarm_timers[i].period = ptmr->OSTmrState == OS_TMR_STATE_RUNNING ?
+                             ptmr->OSTmrPeriod : 0;
+    alt_irq_enable_all(context);
+  }
 }
-void statisticTask(void* pdata)
+
+/* SW timer ticks from 'time' to the next expiry, 0 if none is running */
+static INT32U alarm_next(INT32U time)
 {
-    while(1)
-    {
-        printStackSize(TASK_STAT_PRIORITY);
-        printStackSize(STARTTASK_PRIO);
-        printStackSize(WATCHDOGTASK_PRIO);
-        printStackSize(ShowCPUTASK_RPIO);
-        printStackSize(VEHICLETASK_PRIO);
-        printStackSize(CONTROLTASK_PRIO);
-        printStackSize(BUTTONTASK_PRIO);
-        printStackSize(SWITCHTASK_PRIO);
-        printStackSize(EXTRALOADTASK_PRIO);
-        printStackSize(OVERLOADTASK_RPIO);
-        // OSTimeDlyHMSM(0, 0, 0, 4);
-    }
+  struct alarm_timer *a;
+  INT32S remain;
+  INT32U next = 0;
+  INT8U i;
+
+  for (i = 0; i < ALARM_TIMERS; i++) {
+    a = &alarm_timers[i];
+    if (a->period == 0)
+      continue;
+    /* Expiries up to 'time' are signalled, not yet processed */
+    remain = (INT32S) (a->match - time);
+    while (remain <= 0)
+      remain += a->period;
+    if (next == 0 || (INT32U) remain < next)
+      next = remain;
+  }
+  return next;
 }
+#endif
+
+/* What a SW timer releases: the semaphore of a task and its monitor id */
+struct task_release {
+  OS_EVENT **sem;
+  INT8U      monitor;
+};
+
+static struct task_release VehicleRelease = { &VehicleSem, MON_VEHICLE };
+static struct task_release ControlRelease = { &ControlSem, MON_CONTROL };
+static struct task_release ShowCPURelease = { &ShowCPUSem, MON_SHOWCPU };
 
-void SemPostFunc (void *ptmr, OS_EVENT *semptr)
+/* Callback of the SW timers, 'parg' is the task_release of the timer */
+void SemPostFunc (void *ptmr, void *parg)
 {
-  OSSemPost(semptr);
+  struct task_release *release = (struct task_release *) parg;
+
+#if CRUISE_TICKLESS
+  alarm_timer_update((OS_TMR *) ptmr);
+#endif
+  monitor_release(release->monitor);
+  task_timing_release(*release->sem);
+  OSSemPost(*release->sem);
 }
 
 int buttons_pressed(void)
@@ -162,82 +256,181 @@ int switches_pressed(void)
  */
 alt_u32 alarm_handler(void* context)
 {
+#if CRUISE_TICKLESS
+  INT32U n;
+
+  cpu_account_isr_enter();
+  for (n = 0; n < alarm_signals; n++)
+    OSTmrSignal();
+  alarm_tmr_time += alarm_signals;
+  alarm_signals = alarm_next(alarm_tmr_time);
+  if (alarm_signals == 0)
+    alarm_signals = 1;          /* No timer running: check again */
+  cpu_account_isr_exit(CPU_ISR_ALARM);
+
+  return alarm_signals * delay;
+#else
+  cpu_account_isr_enter();
+  task_timing_alarm();
   OSTmrSignal(); /* Signals a 'tick' to the SW timers */
+  cpu_account_isr_exit(CPU_ISR_ALARM);
   
   return delay;
+#endif
 }
 
-static int b2sLUT[] = {0x40, //0
-                 0x79, //1
-                 0x24, //2
-                 0x30, //3
-                 0x19, //4
-                 0x12, //5
-                 0x02, //6
-                 0x78, //7
-                 0x00, //8
-                 0x18, //9
-                 0x3F, //-
-};
-
+#if CRUISE_INPUT_IRQ
 /*
- * convert int to seven segment display format
+ * Interrupt driven inputs
+ *
+ * The PIO cores of the keys and switches capture any edge and raise their
+ * interrupt.  The ISR posts only the flags that changed to EngineStatus
+ * and mirrors the inputs on the LEDs, as ButtonIOTask and SwitchIOTask do
+ * by polling.  After an edge the PIO is locked for INPUT_DEBOUNCE_MS:
+ * edges in that time are counted as bounces and the state is sampled
+ * again when the lockout ends.
  */
-int int2seven(int inval){
-    return b2sLUT[inval];
+typedef struct input_pio {
+  alt_u32   base;
+  alt_u32   irq;
+  alt_u32   irq_mask;   /* Inputs with edge interrupt */
+  alt_u32   state;      /* Last state taken over, 1 = pressed / on */
+  INT8U     locked;     /* Debounce lockout running */
+  alt_alarm debounce;
+} input_pio;
+
+struct input_irq_stats {
+  INT32U irqs;          /* Interrupts taken */
+  INT32U bounces;       /* Edges ignored during a lockout */
+  INT32U posts;         /* OSFlagPost calls issued */
+} input_stats;
+
+static input_pio input_keys = { DE2_PIO_KEYS4_BASE, DE2_PIO_KEYS4_IRQ,
+                                0x01|GAS_PEDAL_FLAG|BRAKE_PEDAL_FLAG|CRUISE_CONTROL_FLAG };
+static input_pio input_switches = { DE2_PIO_TOGGLES18_BASE, DE2_PIO_TOGGLES18_IRQ,
+                                    0x3ff };
+
+static alt_u32 input_read(input_pio *pio)
+{
+  if (pio->base == DE2_PIO_KEYS4_BASE)
+    return pio->irq_mask & buttons_pressed();
+  return pio->irq_mask & switches_pressed();
 }
 
-/*
- * output current velocity on the seven segement display
- */
-void show_velocity_on_sevenseg(INT8S velocity){
-  int tmp = velocity;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
-  INT8U out_sign = 0;
-
-  if(velocity < 0){
-     out_sign = int2seven(10);
-     tmp *= -1;
-  }else{
-     out_sign = int2seven(0);
+/* The EngineStatus flags of a state of 'pio' */
+static OS_FLAGS input_flags(input_pio *pio, alt_u32 state)
+{
+  if (pio->base == DE2_PIO_KEYS4_BASE)
+    return state & (GAS_PEDAL_FLAG|BRAKE_PEDAL_FLAG|CRUISE_CONTROL_FLAG);
+  return ((state & 0x01) ? ENGINE_FLAG : 0) | ((state & 0x02) ? TOP_GEAR_FLAG : 0);
+}
+
+/* Takes over the current state of 'pio', called with interrupts disabled */
+static void input_update(input_pio *pio)
+{
+  INT8U err;
+  alt_u32 state = input_read(pio);
+  alt_u32 old_state = pio->state;
+  OS_FLAGS old_flags = input_flags(pio, pio->state);
+  OS_FLAGS new_flags = input_flags(pio, state);
+
+  if (state == pio->state)
+    return;
+  pio->state = state;
+
+  if (new_flags & ~old_flags) {
+    OSFlagPost(EngineStatus, new_flags & ~old_flags, OS_FLAG_SET, &err);
+    input_stats.posts++;
+  }
+  if (old_flags & ~new_flags) {
+    OSFlagPost(EngineStatus, old_flags & ~new_flags, OS_FLAG_CLR, &err);
+    input_stats.posts++;
   }
 
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-  
-  out = int2seven(0) << 21 |
-            out_sign << 14 |
-            out_high << 7  |
-            out_low;
-  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_LOW28_BASE,out);
+  if (pio->base == DE2_PIO_KEYS4_BASE) {
+    if (state & ~old_state & 0x01)
+      dump_request();               /* KEY0 */
+    /* KEY1..3 on LEDG2, LEDG4 and LEDG6 */
+    display_leds_green(LED_GREEN_KEYS,
+                       (state&0x02)<<1|(state&0x04)<<2|(state&0x08)<<3);
+  } else {
+    display_leds_red(LED_RED_SWITCHES, state);
+  }
+}
+
+/* End of the debounce lockout (alarm callback, runs in the timer ISR) */
+static alt_u32 input_debounce_end(void* context)
+{
+  input_pio *pio = (input_pio *) context;
+
+  if (input_read(pio) != pio->state) {
+    /* Changed during the lockout: take it over and lock again */
+    input_update(pio);
+    return alt_ticks_per_second() * INPUT_DEBOUNCE_MS / 1000;
+  }
+  pio->locked = 0;
+  return 0;
+}
+
+static void input_isr(void* context, alt_u32 id)
+{
+  input_pio *pio = (input_pio *) context;
+
+  cpu_account_isr_enter();
+  input_stats.irqs++;
+  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(pio->base, 0);
+  if (pio->locked) {
+    input_stats.bounces++;
+  } else {
+    input_update(pio);
+    pio->locked = 1;
+    alt_alarm_start(&pio->debounce,
+                    alt_ticks_per_second() * INPUT_DEBOUNCE_MS / 1000,
+                    input_debounce_end, pio);
+  }
+  cpu_account_isr_exit(CPU_ISR_INPUT);
+}
+
+static void input_irq_start(input_pio *pio)
+{
+  pio->state = 0;
+  input_update(pio);   /* Post the inputs that are already active */
+  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(pio->base, 0);
+  alt_irq_register(pio->irq, pio, input_isr);
+  IOWR_ALTERA_AVALON_PIO_IRQ_MASK(pio->base, pio->irq_mask);
 }
 
 /*
- * shows the target velocity on the seven segment display (HEX5, HEX4)
- * when the cruise control is activated (0 otherwise)
+ * Starts the interrupt driven inputs, after EngineStatus is created
  */
-void show_target_velocity(INT8U target_vel)
+void input_irq_init(void)
 {
-  int tmp = target_vel;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
+  alt_irq_context context;
 
+  context = alt_irq_disable_all();
+  input_irq_start(&input_keys);
+  input_irq_start(&input_switches);
+  alt_irq_enable_all(context);
+}
 
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-  
-  out = int2seven(0) << 21 |
-        int2seven(0) << 14 |
-            out_high << 7  |
-            out_low;
-  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_HIGH28_BASE,out);
+/*
+ * Logs the counters.  The polling tasks make 4 kernel calls every
+ * 100 ms (ButtonIOTask) and 3 every 10 ms (SwitchIOTask).
+ */
+void input_irq_report(void)
+{
+  INT32U ms = OSTimeGet() * 1000 / OS_TICKS_PER_SEC;
+  INT32U polling = ms / 100 * 4 + ms / 10 * 3;
+
+  LOG4(LOG_INPUTS, input_stats.irqs, input_stats.bounces, input_stats.posts,
+       polling > input_stats.posts ? polling - input_stats.posts : 0);
 }
+#endif
 
 /*
- * indicates the position of the vehicle on the track with the four leftmost red LEDs
+ * indicates the position of the vehicle on the track with the red LEDs
+ * LEDR17 to LEDR12; the track table gives the LED of each segment, e.g.
+ * for the 2.4 km loop:
  * LEDR17: [0m, 400m)
  * LEDR16: [400m, 800m)
  * LEDR15: [800m, 1200m)
@@ -245,66 +438,17 @@ void show_target_velocity(INT8U target_vel)
  * LEDR13: [1600m, 2000m)
  * LEDR12: [2000m, 2400m]
  */
-void show_position(INT16U position)
+void show_position(const struct track_segment *segment)
 {
-  INT16U temp=position;
-  INT32U out=1,tmp;
-  if(temp<4000)
-    tmp=out<<17; 
-  else if(temp<8000)
-    tmp=out<<16;
-    else if(temp<12000)
-      tmp=out<<15;
-      else if(temp<16000)
-        tmp=out<<14;
-        else if(temp<20000)
-          tmp=out<<13;
-          else
-            tmp=out<<12;
-    led_red=(0x3ff&led_red)|(0xffc00&tmp);
-    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE,led_red);  
+  display_leds_red(LED_RED_POSITION, (INT32U)1<<segment->led);
 }
 
 /*
- * The function 'adjust_position()' adjusts the position depending on the
- * acceleration and velocity.
+ * LEDG0 shows whether the cruise control is active
  */
- INT16U adjust_position(INT16U position, INT16S velocity,
-                        INT8S acceleration, INT16U time_interval)
+void show_cruise_control(enum active state)
 {
-  INT16S new_position = position + velocity * time_interval / 1000
-    + acceleration / 2  * (time_interval / 1000) * (time_interval / 1000);
-
-  if (new_position > 24000) {
-    new_position -= 24000;
-  } else if (new_position < 0){
-    new_position += 24000;
-  }
-  
-  show_position(new_position);
-  return new_position;
-}
- 
-/*
- * The function 'adjust_velocity()' adjusts the velocity depending on the
- * acceleration.
- */
-INT16S adjust_velocity(INT16S velocity, INT8S acceleration,  
-		       enum active brake_pedal, INT16U time_interval)
-{
-  INT16S new_velocity;
-  INT8U brake_retardation = 200;
-
-  if (brake_pedal == off)
-    new_velocity = velocity  + (float) (acceleration * time_interval) / 1000.0;
-  else {
-    if (brake_retardation * time_interval / 1000 > velocity)
-      new_velocity = 0;
-    else
-      new_velocity = velocity - brake_retardation * time_interval / 1000;
-  }
-  
-  return new_velocity;
+  display_leds_green(LED_GREEN_0, state==on ? LED_GREEN_0 : 0);
 }
 
 /*
@@ -313,99 +457,52 @@ INT16S adjust_velocity(INT16S velocity, INT8S acceleration,
 void VehicleTask(void* pdata)
 { 
   INT8U err;  
-  void* msg;
-  INT8U* throttle; 
-  INT8S acceleration;  /* Value between 40 and -20 (4.0 m/s^2 and -2.0 m/s^2) */
-  INT8S retardation;   /* Value between 20 and -10 (2.0 m/s^2 and -1.0 m/s^2) */
-  INT16U position = 0; /* Value between 0 and 20000 (0.0 m and 2000.0 m)  */
-  INT16S velocity = 0; /* Value between -200 and 700 (-20.0 m/s amd 70.0 m/s) */
-  INT16S wind_factor;   /* Value between -10 and 20 (2.0 m/s^2 and -1.0 m/s^2) */
+  INT8U throttle; 
+  struct vehicle_state state = { 0 };
+  struct control_state control;
+  struct cruise_vehicle vehicle;
+  INT32U now, last = 0;
+  INT16U interval;      /* ms since the last release */
+  INT16U log_count = 0;
 
   printf("Vehicle task created!\n");
+  cruise_vehicle_init(&vehicle);
 
   while(1)
     {
-      err = OSMboxPost(Mbox_Velocity, (void *) &velocity);
+      state.velocity = vehicle.plant.velocity;
+      state.position = vehicle.plant.position;
+      vehicle_state_publish(&state);
+      task_timing_end(TIMING_VEHICLE);
+      monitor_checkin(MON_VEHICLE);
 
       // OSTimeDlyHMSM(0,0,0,VEHICLE_PERIOD); 
       OSSemPend(VehicleSem,0,&err);
-
-      /* Non-blocking read of mailbox: 
-	   - message in mailbox: update throttle
-	   - no message:         use old throttle
-      */
-      msg = OSMboxPend(Mbox_Throttle, 1, &err); 
-      if (err == OS_NO_ERR) 
-	     throttle = (INT8U*) msg;
-
-      /* Retardation : Factor of Terrain and Wind Resistance */
-      if (velocity > 0)
-	     wind_factor = velocity * velocity / 10000 + 1;
-      else 
-	     wind_factor = (-1) * velocity * velocity / 10000 + 1;
-         
-      if (position < 4000) 
-         retardation = wind_factor; // even ground
-      else if (position < 8000)
-          retardation = wind_factor + 15; // traveling uphill
-        else if (position < 12000)
-            retardation = wind_factor + 25; // traveling steep uphill
-          else if (position < 16000)
-              retardation = wind_factor; // even ground
-            else if (position < 20000)
-                retardation = wind_factor - 10; //traveling downhill
-              else
-                  retardation = wind_factor - 5 ; // traveling steep downhill
-                  
-      acceleration = *throttle / 2 - retardation;	  
-      position = adjust_position(position, velocity, acceleration, 300); 
-      velocity = adjust_velocity(velocity, acceleration, brake_pedal, 300); 
-      printf("Position: %dm\n", position / 10);
-      printf("Velocity: %4.1fm/s\n", velocity /10.0);
-      printf("Throttle: %dV\n", *throttle / 10);
-      show_velocity_on_sevenseg((INT8S) (velocity / 10));
+      task_timing_start(TIMING_VEHICLE);
+
+      /* The plant integrates over the time that really passed */
+      now = OSTimeGet();
+      interval = last == 0 ? VEHICLE_PERIOD :
+        (INT16U) ((now - last) * 1000 / OS_TICKS_PER_SEC);
+      last = now;
+
+      /* Non-blocking read of the latest throttle of ControlTask */
+      control_state_read(&control);
+      throttle = control.throttle;
+      state.throttle = throttle;
+
+      cruise_vehicle_step(&vehicle, throttle, control.brake_pedal, interval);
+      show_position(&track[vehicle.segment]);
+      if (++log_count >= LOG_STATE_PERIOD / VEHICLE_PERIOD) {
+        log_count = 0;
+        LOG1(LOG_POSITION, vehicle.plant.position);
+        LOG1(LOG_VELOCITY, vehicle.plant.velocity);
+        LOG1(LOG_THROTTLE, throttle);
+      }
+      display_velocity((INT8S) (vehicle.plant.velocity / 10));
     }
 } 
  
-/*
- *  Incremented PID for speed control
- */
-struct _pid{
-INT16U SetSpeed;     //定义设定值
-INT16U ActualSpeed;    //定义实际值
-INT16S err;        //定义偏差值
-INT16S err_last;     //定义上一个偏差值
-float Kp,Ki,Kd;     //定义比例、积分、微分系数
-INT16S voltage;      //定义电压值（控制执行器的变量）
-INT16S integral;       //定义积分值
-}pid;
-
-//项目中获取到的参数
-void PID_init(){
-  printf("PID_init begin \n");
-  pid.SetSpeed=0;
-  // pid.ActualSpeed=0;
-  pid.err=0;
-  pid.err_last=0;
-  pid.voltage=0;
-  pid.integral=0;
-  pid.Kp=20;       //自己设定
-  pid.Ki=0.08;     //自己设定
-  pid.Kd=0.2;       //自己设定
-  printf("PID_init end \n");
-}
-
-INT16S PID_realize(INT16U speed, INT16U velocity){
-  pid.SetSpeed=speed;           //设定值
-  pid.err=pid.SetSpeed-velocity; //设定值-实际值
-  pid.integral+=pid.err;          //积分值，偏差累加
-  pid.voltage=pid.Kp*pid.err+pid.Ki*pid.integral+pid.Kd*(pid.err-pid.err_last);
-  pid.err_last=pid.err;         //上一个偏差值
-  // pid.ActualSpeed=pid.voltage*1.0;    //算出实际值
-  return pid.voltage;         //返回
-}
-
-
 /*
  * The task 'ControlTask' is the main task of the application. It reacts
  * on sensors and generates responses.
@@ -414,244 +511,54 @@ INT16S PID_realize(INT16U speed, INT16U velocity){
 void ControlTask(void* pdata)
 {
   INT8U err;
-  INT8U throttle = 0; /* Value between 0 and 80, which is interpreted as between 0.0V and 8.0V */
-  void* msg;
-  INT16S* current_velocity;
-  INT16U target_vel;
-  INT16S div=0,count=0;
-  INT32S throttleCul,slope;
-  INT32U countercruise=0;
-  OS_FLAGS value;
+  struct vehicle_state state;
+  struct control_state control;
+  static struct cruise_controller cruise;  /* Off the stack */
+  struct input_snapshot in, last = { 0, off, off, off, off, off };
+#if CRUISE_CONTROL_TIMING
+  INT32U release, response, cycles = 0, response_max = 0, response_sum = 0;
+#endif
 
   printf("Control Task created!\n");
-  PID_init();
+  cruise_controller_init(&cruise);
   while(1)
     {
-     msg = OSMboxPend(Mbox_Velocity, 0, &err);
-      current_velocity = (INT16S*) msg;
+      task_timing_start(TIMING_CONTROL);
+      /* Released after VehicleTask, which has the higher priority */
+      vehicle_state_read(&state);
+#if CRUISE_CONTROL_TIMING
+      release = OSTimeGet();
+#endif
       /*
-       * Engine control
+       * One snapshot of all inputs per cycle, taken without blocking; if
+       * the flags cannot be read, the last snapshot (at first all off)
+       * stays
        */
-      value = OSFlagPend(EngineStatus,
-        ENGINE_FLAG,
-        OS_FLAG_WAIT_SET_ALL,
-        1,
-        &err);
-    switch (err) {
-      case OS_ERR_NONE:
-      engine=on;
-      break;
-      case OS_ERR_TIMEOUT:
-      // engine=off;
-      break;
-    }
-    // printf("Velocity in control: %4.1fm/s\n", *current_velocity /10.0);
-    if(*current_velocity==0)
-    {
-      value = OSFlagPend(EngineStatus,
-        ENGINE_FLAG,
-        OS_FLAG_WAIT_CLR_ALL,
-        1,
-        &err);
-    switch (err) {
-      case OS_ERR_NONE:
-      engine=off;
-      break;
-      case OS_ERR_TIMEOUT:
-      break;
-    }
-    }
-    if(engine==on)
-    {
-
-      // throttle=40;
-      if(gas_pedal==on)
-        throttle++;
-      else if(throttle!=0&&cruise_control==off)
-        throttle--;
-      // else
-      //   throttle=0;
-      
-      err = OSMboxPost(Mbox_Throttle, (void *) &throttle);
-    /*
-     * Cruise control
-     */
-    if(*current_velocity>=200)
-    {
-     value = OSFlagPend(EngineStatus,
-        CRUISE_CONTROL_FLAG+TOP_GEAR_FLAG,
-        OS_FLAG_WAIT_SET_ALL,
-        1,
-        &err);
-    if(err==OS_ERR_NONE)
-    {
-        value = OSFlagPend(EngineStatus,
-        GAS_PEDAL_FLAG+BRAKE_PEDAL_FLAG,
-        OS_FLAG_WAIT_CLR_ALL,
-        1,
-        &err);
-      switch (err) {
-      case OS_ERR_NONE:
-      // printf("cruse control on\n");
-      cruise_control=on;
-      countercruise++;
-      break;
-      case OS_ERR_TIMEOUT:
-      // printf("gas pedal or brake doesn't release\n");
-      cruise_control=off;
-      countercruise=0;
-      break;
-    }
-    }
-      else
-      {
-      // printf("cruise or top gear not ready\n");
-      cruise_control=off;
-      countercruise=0;
-      }  
-    }
-    else
-    {
-      // printf("velocity not enough\n");
-      cruise_control=off;
-      countercruise=0;
-    }
-    if(cruise_control==on&&countercruise==1)
-    {
-      target_vel=*current_velocity;
-    }
-    if(cruise_control==on)
-    {
-      count=PID_realize(target_vel,*current_velocity);
-      // printf("Actuator %d\n", count);
-      // throttle=throttle+10;
-      led_green=(0xfe&led_green)|(0x01);
-      show_target_velocity((INT8U)(target_vel/10));
-      // switch (led_red&0xffff0) {
-      //   case 0x20000:
-      //   // throttle=target_vel*target_vel/5000 + 2 + div;
-      //   slope=0;
-      //   break;
-      //   case 0x10000:
-      //   // throttle=target_vel*target_vel/5000 + 32 + div;
-      //   slope=15;
-      //   break;
-      //   case 0x08000:
-      //   slope=25;
-      //   // throttle=target_vel*target_vel/5000 + 52 + div;
-      //   break;
-      //   case 0x04000:
-      //   slope=0;
-      //   // throttle=target_vel*target_vel/5000 + 2 + div;
-      //   break;
-      //   case 0x02000:
-      //   slope=-10;
-      //   // throttle=0;
-      //   break;
-      //   case 0x01000:
-      //   slope=-5;
-      //   // throttle=target_vel*target_vel/5000 - 8 + div;
-      //   // if(throttle>80)
-      //   //   throttle=0;
-      //   break;
-      // }
-      // if(div>=15)
-      // div=15;
-      // if(div<=-15)
-      // div=-15;
-      throttleCul=2*((count*count)/10000+1);
-      // printf("throttle needed %d\n", throttleCul);
-      if (throttleCul<0)
-        throttle=0;
-      else if(throttleCul>80)
-        throttle=80;
-      else
-        throttle=throttleCul; 
-      // if(*current_velocity<target_vel)
-      // {
-      //   // count++;
-      //   // if(count%3==0)
-      //   // div++;
-      //   throttle++;
-      // }
-      // if(*current_velocity>target_vel)
-      // {
-      //   // count++;
-      //   // if(count%3==0)
-      //   // div--;
-      //   throttle--;
-      // }
-    }
-    else
-      led_green=(0xfe&led_green)|(0x00);
-    if(cruise_control==off)
-      show_target_velocity(0);
-    /*
-     * Gas Pedal
-     */
-    value = OSFlagPend(EngineStatus,
-        GAS_PEDAL_FLAG,
-        OS_FLAG_WAIT_SET_ALL,
-        1,
-        &err);
-    switch (err) {
-      case OS_ERR_NONE:
-      gas_pedal=on;
-      cruise_control=off;
-      break;
-      case OS_ERR_TIMEOUT:
-      gas_pedal=off;
-      break;
-    }
-    /*
-     * Brake
-     */
-    value = OSFlagPend(EngineStatus,
-        BRAKE_PEDAL_FLAG,
-        OS_FLAG_WAIT_SET_ALL,
-        1,
-        &err);
-    switch (err) {
-      case OS_ERR_NONE:
-      brake_pedal=on;
-      cruise_control=off;
-      break;
-      case OS_ERR_TIMEOUT:
-      brake_pedal=off;
-      break;
-    }
-    /*
-     * Gear
-     */
-    value = OSFlagPend(EngineStatus,
-        TOP_GEAR_FLAG,
-        OS_FLAG_WAIT_SET_ALL,
-        1,
-        &err);
-    switch (err) {
-      case OS_ERR_NONE:
-      top_gear=on;
-      // cruise_control=off;
-      break;
-      case OS_ERR_TIMEOUT:
-      top_gear=off;
-      break;
-    }
-      // OSTimeDlyHMSM(0,0,0, CONTROL_PERIOD);
-    // if(cruise_control==off&&gas_pedal==off)
-    //   throttle=0;
-    }
-    else
-    {
-      if(cruise_control==off&&gas_pedal==off)
-      throttle=0; 
-      err = OSMboxPost(Mbox_Throttle, (void *) &throttle); 
-    }
-    if (throttle>80)
-    {
-      throttle=80;
-    }
-    OSSemPend(ControlSem,0,&err);
+      if (input_snapshot_take(EngineStatus, &in) != OS_NO_ERR)
+        in = last;
+      last = in;
+      cruise_controller_step(&cruise, &in, state.position, state.velocity);
+
+      show_cruise_control(cruise.cruise_control);
+      display_target_velocity(cruise.cruise_control==on ?
+                              (INT8U)(cruise.target_vel/10) : 0);
+      control.throttle=cruise.throttle;
+      control.cruise_control=cruise.cruise_control;
+      control.target_velocity=cruise.cruise_control==on ? cruise.target_vel : 0;
+      control.brake_pedal=cruise.brake_pedal;
+      control_state_publish(&control);
+      task_timing_end(TIMING_CONTROL);
+      monitor_checkin(MON_CONTROL);
+#if CRUISE_CONTROL_TIMING
+      /* Response time in ticks, from the velocity read to the end of the cycle */
+      response = OSTimeGet() - release;
+      response_sum += response;
+      if (response > response_max)
+        response_max = response;
+      if (++cycles % CRUISE_CONTROL_TIMING == 0)
+        LOG3(LOG_CONTROL_RESPONSE, response_max, response_sum, cycles);
+#endif
+      OSSemPend(ControlSem,0,&err);
     }
 }
 /*
@@ -660,70 +567,180 @@ void ControlTask(void* pdata)
 void ShowCPUUsage(void* pdata)
 {
   INT8U err;
+#if CRUISE_INPUT_IRQ
+  INT32U n=0;
+#endif
   while(1)
   {
     OSSemPend(ShowCPUSem,0,&err);
+    task_timing_start(TIMING_SHOWCPU);
     // printf("OSIdleCtr: %d\n", OSIdleCtr);
     // printf("OSIdleCtrMax: %d\n", OSIdleCtrMax);
-    printf("CPU usage is %ld%%\n", OSCPUUsage);
+    LOG1(LOG_CPU_USAGE, OSCPUUsage);
+#if CRUISE_INPUT_IRQ
+    if(++n%20==0)
+      input_irq_report();
+#endif
+#if !CRUISE_LOG
+    dump_poll();
+#endif
+    task_timing_end(TIMING_SHOWCPU);
+    monitor_checkin(MON_SHOWCPU);
   }
 }
+/*
+ * Reaction to a deadline miss (monitor.c): logged, never printed here.
+ * A missing heartbeat of OverloadDetection is the overload of the system.
+ */
+void deadline_missed(INT8U id, INT32U lateness)
+{
+  if(id==MON_OVERLOAD)
+    LOG0(LOG_OVERLOAD);
+  else
+    LOG2(LOG_DEADLINE_MISS, id, lateness);
+}
+
+/*
+ * The Watchdog checks the deadlines of all monitored tasks.  In tickless
+ * mode it sleeps until the first miss the scan can count, instead of
+ * waking every MONITOR_SCAN_PERIOD ms.
+ */
 void Watchdog(void* pdata)
 {
-  INT8U err;
+#if CRUISE_TICKLESS
+  INT32S wait;
+#endif
   while(1)
   {
-    OSSemPend(OK,300,&err);
-    if(err==OS_ERR_TIMEOUT)
-      printf("System Overload---------------------------------\n");
+#if CRUISE_TICKLESS
+    wait = (INT32S) (monitor_next_due() - OSTimeGet());
+    OSTimeDly(wait < 1 ? 1 : wait > 0xffff ? 0xffff : (INT16U) wait);
+#else
+    OSTimeDlyHMSM(0,0,0,MONITOR_SCAN_PERIOD);
+#endif
+    monitor_scan();
   }
 }
+/*
+ * DisplayTask writes the displays and LEDs that changed (display.c)
+ */
+void DisplayTask(void* pdata)
+{
+  while(1)
+  {
+    display_flush();
+    monitor_checkin(MON_DISPLAY);
+    OSTimeDlyHMSM(0,0,0,DISPLAY_PERIOD);
+  }
+}
+/*
+ * OverloadDetection runs at the lowest priority but the log's; its
+ * heartbeat stops when the CPU is overloaded
+ */
 void OverloadDetection(void* pdata)
 {
-  INT8U err;
   while(1)
   {
   OSTimeDlyHMSM(0,0,0,290);
-  OSSemPost(OK);
-  
+  monitor_checkin(MON_OVERLOAD);
   }
 }
+/*
+ * ExtraLoad burns 'usage' percent of its period (load.c) and is released
+ * every EXTRALOAD_PERIOD ms; '*next' is the tick of the next release
+ */
+static void extra_load_period(INT16U usage, INT32U *next)
+{
+  INT32S wait;
+
+  monitor_release(MON_EXTRALOAD);
+  load_burn_us((INT32U) usage * EXTRALOAD_PERIOD * 10);
+  monitor_checkin(MON_EXTRALOAD);
+  *next += EXTRALOAD_PERIOD * OS_TICKS_PER_SEC / 1000;
+  wait = (INT32S) (*next - OSTimeGet());
+  if (wait > 0)             /* Otherwise overrun: released already */
+    OSTimeDly((INT16U) wait);
+}
+
+#if CRUISE_LOAD_SWEEP
+/*
+ * Steps the load from 0 to 100 % and prints the worst response times and
+ * deadline misses of VehicleTask and ControlTask and the watchdog
+ * timeouts for each level
+ */
+static void extra_load_sweep(INT32U *next)
+{
+  struct timing_summary vehicle[100/CRUISE_LOAD_SWEEP + 1];
+  struct timing_summary control[100/CRUISE_LOAD_SWEEP + 1];
+  INT32U misses[100/CRUISE_LOAD_SWEEP + 1][2];
+  INT32U overload[100/CRUISE_LOAD_SWEEP + 1];
+  struct monitor_stats start, end;
+  INT16U usage;
+  int n, k;
+
+  for (n = 0, usage = 0; usage <= 100; n++, usage += CRUISE_LOAD_SWEEP) {
+    task_timing_reset();
+    monitor_query(MON_OVERLOAD, &start);
+    for (k = 0; k < LOAD_SWEEP_PERIODS; k++)
+      extra_load_period(usage, next);
+    task_timing_query(TIMING_VEHICLE, TIMING_RESPONSE, &vehicle[n]);
+    task_timing_query(TIMING_CONTROL, TIMING_RESPONSE, &control[n]);
+    misses[n][0] = task_timing_misses(TIMING_VEHICLE);
+    misses[n][1] = task_timing_misses(TIMING_CONTROL);
+    monitor_query(MON_OVERLOAD, &end);
+    overload[n] = end.misses - start.misses;
+  }
+
+  printf("Load sweep, %d periods of %d ms per level\n",
+         LOAD_SWEEP_PERIODS, EXTRALOAD_PERIOD);
+  printf("load%%  VehicleTask max/p99 [us] misses  ControlTask max/p99 [us]"
+         " misses  overloads\n");
+  for (k = 0; k < n; k++)
+    printf("%4d  %12lu %9lu %6lu  %12lu %9lu %6lu  %9lu\n",
+           k * CRUISE_LOAD_SWEEP,
+           (unsigned long) vehicle[k].max, (unsigned long) vehicle[k].p99,
+           (unsigned long) misses[k][0],
+           (unsigned long) control[k].max, (unsigned long) control[k].p99,
+           (unsigned long) misses[k][1], (unsigned long) overload[k]);
+}
+#endif
+
 void ExtraLoad(void* pdata)
 {
   INT16U usage;
-  int x,i,j;
+  INT32U next = OSTimeGet();
+
+#if CRUISE_LOAD_SWEEP
+  extra_load_sweep(&next);
+#endif
   while(1)
   {
-  usage=((led_red&0x3f0)>>4)*2;
+  /* SW4..9: percent of the CPU */
+  usage=((switches_pressed()&0x3f0)>>4)*2;
   if (usage>100)
   {
     usage=100;
   }
-  if(usage>0)
-  for (i = 0; i < usage; ++i)
-  {
-    for (j = 0; j <410; ++j)
-    {
-      x=j*i;
-      // printf("%d\n", OSCPUUsage);
-    }
-  }
-  printf("%d\n", usage);
-  OSTimeDlyHMSM(0,0,0,300);
+  LOG1(LOG_EXTRA_LOAD, usage);
+  extra_load_period(usage, &next);
   }
 }
 
+#if !CRUISE_INPUT_IRQ
 /*
  * SwitchIO task reads Switch periodically.
  */
 void ButtonIOTask(void* pdata)
 {
   INT8U err;
-  INT8U temp,temp1,temp2,temp3,temp4;
-  OS_FLAGS flags;
+  INT8U temp,temp1,temp2,temp3;
+  INT8U key0=0;
   while(1)
   {
     temp=0x0f&buttons_pressed();
+    if(temp&0x01&~key0)
+      dump_request();
+    key0=temp&0x01;
     temp1=temp&GAS_PEDAL_FLAG;
 
     temp2=temp&BRAKE_PEDAL_FLAG;
@@ -751,8 +768,7 @@ void ButtonIOTask(void* pdata)
     temp=temp1|temp2|temp3;
     // temp=temp*temp;
     // printf("NO KEY?!!\n");
-    led_green=(0x01&led_green)|(0xfe&temp);
-    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE,led_green);
+    display_leds_green(LED_GREEN_KEYS,temp);
     OSTimeDlyHMSM(0,0,0, 100);
   }
 }
@@ -791,11 +807,11 @@ void SwitchIOTask(void* pdata)
     // printf("OS_ERR_FLAG_INVALID_OPT\n");
     // break;
     // }
-    led_red=(0xffc00&led_red)|(0x3ff&temp);
-    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE,led_red);
+    display_leds_red(LED_RED_SWITCHES,temp);
     OSTimeDlyHMSM(0,0,0, 10);
   }
 }
+#endif
 /* 
  * The task 'StartTask' creates all other tasks kernel objects and
  * deletes itself afterwards.
@@ -804,11 +820,17 @@ void SwitchIOTask(void* pdata)
 void StartTask(void* pdata)
 {
   INT8U err;
-  void* context;
-  BOOLEAN status;
+  int extra_load;
 
   static alt_alarm alarm;     /* Is needed for timer ISR function */
   
+  /* An uncalibrated ExtraLoad would burn nothing: it is not started */
+  extra_load = load_calibrate() == 0;
+  if (!extra_load)
+    printf("ExtraLoad NOT started: the load cannot be calibrated\n");
+  task_timing_init();
+  cpu_account_init();
+
   /* Base resolution for SW timer : HW_TIMER_PERIOD ms */
   delay = alt_ticks_per_second() * HW_TIMER_PERIOD / 1000; 
   printf("delay in ticks %d\n", delay);
@@ -819,7 +841,7 @@ void StartTask(void* pdata)
   if (alt_alarm_start (&alarm,
       delay,
       alarm_handler,
-      context) < 0)
+      NULL) < 0)
       {
           printf("No system clock available!n");
       }
@@ -828,46 +850,76 @@ void StartTask(void* pdata)
    */
       VehicleSem = OSSemCreate(0);
       ControlSem = OSSemCreate(0);
-      OK = OSSemCreate(0);
       ShowCPUSem=OSSemCreate(0);
+  task_timing_register(TIMING_VEHICLE, "VehicleTask", VehicleSem, VEHICLE_PERIOD);
+  task_timing_register(TIMING_CONTROL, "ControlTask", ControlSem, CONTROL_PERIOD);
+  task_timing_register(TIMING_SHOWCPU, "ShowCPUUsage", ShowCPUSem, SHOWCPU_PERIOD);
+#if !CRUISE_TICKLESS
+  task_timing_register(TIMING_ALARM, "alarm", NULL, HW_TIMER_PERIOD);
+#endif
+
+  /*
+   * Deadline monitor: the timer driven tasks must complete by their next
+   * release, OverloadDetection checks in every 290 ms and is considered
+   * starved after 300 ms
+   */
+  monitor_set_hook(deadline_missed);
+  monitor_register(MON_VEHICLE, "VehicleTask", MONITOR_PERIODIC,
+                   VEHICLE_PERIOD, VEHICLE_PERIOD);
+  monitor_register(MON_CONTROL, "ControlTask", MONITOR_PERIODIC,
+                   CONTROL_PERIOD, CONTROL_PERIOD);
+  monitor_register(MON_SHOWCPU, "ShowCPUUsage", MONITOR_PERIODIC,
+                   SHOWCPU_PERIOD, SHOWCPU_PERIOD);
+  if (extra_load)
+    monitor_register(MON_EXTRALOAD, "ExtraLoad", MONITOR_PERIODIC,
+                     EXTRALOAD_PERIOD, EXTRALOAD_PERIOD);
+  monitor_register(MON_OVERLOAD, "OverloadDetection", MONITOR_HEARTBEAT,
+                   290, 300);
+  monitor_register(MON_DISPLAY, "DisplayTask", MONITOR_HEARTBEAT,
+                   DISPLAY_PERIOD, 2*DISPLAY_PERIOD);
+#if CRUISE_LOG
+  monitor_register(MON_LOG, "LogTask", MONITOR_HEARTBEAT,
+                   LOG_DRAIN_PERIOD, 1000);
+#endif
 
   /* 
    * Create and start Software Timer 
    */
   VehicleTmr = OSTmrCreate(  0,
-                           VEHICLE_PERIOD/100,
+                           VEHICLE_PERIOD/HW_TIMER_PERIOD,
                            OS_TMR_OPT_PERIODIC,
                            SemPostFunc,
-                           VehicleSem,
-                           "Release Vehicle",
+                           &VehicleRelease,
+                           (INT8U *) "Release Vehicle",
                            &err);
   ControlTmr = OSTmrCreate(  0,
-                           CONTROL_PERIOD/100,
+                           CONTROL_PERIOD/HW_TIMER_PERIOD,
                            OS_TMR_OPT_PERIODIC,
                            SemPostFunc,
-                           ControlSem,
-                           "Release Vehicle",
+                           &ControlRelease,
+                           (INT8U *) "Release Control",
                            &err);
   ShowCPUTmr = OSTmrCreate(  0,
-                           5,
+                           SHOWCPU_PERIOD/HW_TIMER_PERIOD,
                            OS_TMR_OPT_PERIODIC,
                            SemPostFunc,
-                           ShowCPUSem,
-                           "Release ShowCPU",
+                           &ShowCPURelease,
+                           (INT8U *) "Release ShowCPU",
                            &err);
-  status = OSTmrStart(VehicleTmr,
-                      &err);
-  status = OSTmrStart(ControlTmr,
-                      &err);
-  status = OSTmrStart(ShowCPUTmr,
-                      &err);
+  OSTmrStart(VehicleTmr, &err);
+  OSTmrStart(ControlTmr, &err);
+  OSTmrStart(ShowCPUTmr, &err);
+#if CRUISE_TICKLESS
+  OSSchedLock();
+  alarm_timer_update(VehicleTmr);
+  alarm_timer_update(ControlTmr);
+  alarm_timer_update(ShowCPUTmr);
+  OSSchedUnlock();
+#endif
   /*
    * Creation of Kernel Objects
    */
-  
-  // Mailboxes
-  Mbox_Throttle = OSMboxCreate((void*) 0); /* Empty Mailbox - Throttle */
-  Mbox_Velocity = OSMboxCreate((void*) 0); /* Empty Mailbox - Velocity */
+  /* Velocity and throttle are exchanged through vehicle_state.c */
    
   /*
    * Create statistics task
@@ -885,108 +937,158 @@ void StartTask(void* pdata)
 	   ControlTask, // Pointer to task code
 	   NULL,        // Pointer to argument that is
 	                // passed to task
-	   &ControlTask_Stack[TASK_STACKSIZE-1], // Pointer to top
+	   &ControlTask_Stack[CONTROLTASK_STACKSIZE-1], // Pointer to top
 							 // of task stack
 	   CONTROLTASK_PRIO,
 	   CONTROLTASK_PRIO,
 	   (void *)&ControlTask_Stack[0],
-	   TASK_STACKSIZE,
+	   CONTROLTASK_STACKSIZE,
 	   (void *) 0,
-	   OS_TASK_OPT_STK_CHK);
+	   OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 
   err = OSTaskCreateExt(
 	   VehicleTask, // Pointer to task code
 	   NULL,        // Pointer to argument that is
 	                // passed to task
-	   &VehicleTask_Stack[TASK_STACKSIZE-1], // Pointer to top
+	   &VehicleTask_Stack[VEHICLETASK_STACKSIZE-1], // Pointer to top
 							 // of task stack
 	   VEHICLETASK_PRIO,
 	   VEHICLETASK_PRIO,
 	   (void *)&VehicleTask_Stack[0],
-	   TASK_STACKSIZE,
+	   VEHICLETASK_STACKSIZE,
 	   (void *) 0,
-	   OS_TASK_OPT_STK_CHK);
+	   OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 
+#if CRUISE_INPUT_IRQ
+  input_irq_init();
+#else
   err = OSTaskCreateExt(
      ButtonIOTask,
      NULL,
-     &ButtonIOTask_Stack[TASK_STACKSIZE-1],
+     &ButtonIOTask_Stack[BUTTONIOTASK_STACKSIZE-1],
      BUTTONTASK_PRIO,
      BUTTONTASK_PRIO,
      (void *)&ButtonIOTask_Stack[0],
-     TASK_STACKSIZE,
+     BUTTONIOTASK_STACKSIZE,
      (void *)0,
-     OS_TASK_OPT_STK_CHK);
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 
   err = OSTaskCreateExt(
      SwitchIOTask,
      NULL,
-     &SwitchIOTask_Stack[TASK_STACKSIZE-1],
+     &SwitchIOTask_Stack[SWITCHIOTASK_STACKSIZE-1],
      SWITCHTASK_PRIO,
      SWITCHTASK_PRIO,
      (void *)&SwitchIOTask_Stack[0],
-     TASK_STACKSIZE,
+     SWITCHIOTASK_STACKSIZE,
      (void *)0,
-     OS_TASK_OPT_STK_CHK);
-  err = OSTaskCreateExt(
-     ExtraLoad,
-     NULL,
-     &ExtraLoadTask_Stack[TASK_STACKSIZE-1],
-     EXTRALOADTASK_PRIO,
-     EXTRALOADTASK_PRIO,
-     (void *)&ExtraLoadTask_Stack[0],
-     TASK_STACKSIZE,
-     (void *)0,
-     OS_TASK_OPT_STK_CHK);
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#endif
+  if (extra_load)
+    err = OSTaskCreateExt(
+       ExtraLoad,
+       NULL,
+       &ExtraLoadTask_Stack[EXTRALOAD_STACKSIZE-1],
+       EXTRALOADTASK_PRIO,
+       EXTRALOADTASK_PRIO,
+       (void *)&ExtraLoadTask_Stack[0],
+       EXTRALOAD_STACKSIZE,
+       (void *)0,
+       OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
   err = OSTaskCreateExt(
      Watchdog,
      NULL,
-     &WatchdogTask_Stack[TASK_STACKSIZE-1],
+     &WatchdogTask_Stack[WATCHDOG_STACKSIZE-1],
      WATCHDOGTASK_PRIO,
      WATCHDOGTASK_PRIO,
      (void *)&WatchdogTask_Stack[0],
-     TASK_STACKSIZE,
+     WATCHDOG_STACKSIZE,
+     (void *)0,
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+  err = OSTaskCreateExt(
+     DisplayTask,
+     NULL,
+     &DisplayTask_Stack[DISPLAYTASK_STACKSIZE-1],
+     DISPLAYTASK_PRIO,
+     DISPLAYTASK_PRIO,
+     (void *)&DisplayTask_Stack[0],
+     DISPLAYTASK_STACKSIZE,
      (void *)0,
-     OS_TASK_OPT_STK_CHK);
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
   err = OSTaskCreateExt(
      OverloadDetection,
      NULL,
-     &OverloadTask_Stack[TASK_STACKSIZE-1],
+     &OverloadTask_Stack[OVERLOADDETECTION_STACKSIZE-1],
      OVERLOADTASK_RPIO,
      OVERLOADTASK_RPIO,
      (void *)&OverloadTask_Stack[0],
-     TASK_STACKSIZE,
+     OVERLOADDETECTION_STACKSIZE,
      (void *)0,
-     OS_TASK_OPT_STK_CHK);
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
   err = OSTaskCreateExt(
      ShowCPUUsage,
      NULL,
-     &ShowCPUTask_Stack[TASK_STACKSIZE-1],
+     &ShowCPUTask_Stack[SHOWCPUUSAGE_STACKSIZE-1],
      ShowCPUTASK_RPIO,
      ShowCPUTASK_RPIO,
      (void *)&ShowCPUTask_Stack[0],
-     TASK_STACKSIZE,
+     SHOWCPUUSAGE_STACKSIZE,
      (void *)0,
-     OS_TASK_OPT_STK_CHK);
-  if (DEBUG == 1)
-  {
-    err= OSTaskCreateExt
-      (statisticTask,                // Pointer to task code
-       NULL,                         // Pointer to argument that is
-                                     // passed to task
-       &stat_stk[TASK_STACKSIZE-1],  // Pointer to top of task stack
-       TASK_STAT_PRIORITY,           // Desired Task priority
-       TASK_STAT_PRIORITY,           // Task ID
-       &stat_stk[0],                 // Pointer to bottom of task stack
-       TASK_STACKSIZE,               // Stacksize
-       (void *)0,                         // Pointer to user supplied memory
-                                     // (not needed here)
-       OS_TASK_OPT_STK_CHK |         // Stack Checking enabled 
-       OS_TASK_OPT_STK_CLR           // Stack Cleared                              
-      );
-      if(err==OS_ERR_NONE)
-        printf("Static Task Created\n");
-  }  
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#if CRUISE_LOG
+  err = OSTaskCreateExt(
+     LogTask,
+     NULL,
+     &LogTask_Stack[LOGTASK_STACKSIZE-1],
+     LOGTASK_PRIO,
+     LOGTASK_PRIO,
+     (void *)&LogTask_Stack[0],
+     LOGTASK_STACKSIZE,
+     (void *)0,
+     OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#endif
+
+  cpu_account_name(VEHICLETASK_PRIO, "VehicleTask");
+  cpu_account_name(CONTROLTASK_PRIO, "ControlTask");
+  cpu_account_name(DISPLAYTASK_PRIO, "DisplayTask");
+#if !CRUISE_INPUT_IRQ
+  cpu_account_name(BUTTONTASK_PRIO, "ButtonIOTask");
+  cpu_account_name(SWITCHTASK_PRIO, "SwitchIOTask");
+#endif
+  cpu_account_name(EXTRALOADTASK_PRIO, "ExtraLoad");
+  cpu_account_name(WATCHDOGTASK_PRIO, "Watchdog");
+  cpu_account_name(OVERLOADTASK_RPIO, "OverloadDetection");
+  cpu_account_name(ShowCPUTASK_RPIO, "ShowCPUUsage");
+#if CRUISE_LOG
+  cpu_account_name(LOGTASK_PRIO, "LogTask");
+#endif
+  cpu_account_name(STARTTASK_PRIO, "StartTask");
+  cpu_account_name(OS_TASK_TMR_PRIO, "OS_TmrTask");
+  cpu_account_name(OS_TASK_STAT_PRIO, "OS_TaskStat");
+  cpu_account_name(OS_TASK_IDLE_PRIO, "Idle");
+  cpu_account_period(VEHICLETASK_PRIO, VEHICLE_PERIOD);
+  cpu_account_period(CONTROLTASK_PRIO, CONTROL_PERIOD);
+  cpu_account_period(DISPLAYTASK_PRIO, DISPLAY_PERIOD);
+  cpu_account_period(EXTRALOADTASK_PRIO, EXTRALOAD_PERIOD);
+  cpu_account_period(ShowCPUTASK_RPIO, SHOWCPU_PERIOD);
+
+  /* The names give the <NAME>_STACKSIZE macros of the report */
+  stack_watch_add(STARTTASK_PRIO, "StartTask", STARTTASK_STACKSIZE);
+  stack_watch_add(VEHICLETASK_PRIO, "VehicleTask", VEHICLETASK_STACKSIZE);
+  stack_watch_add(CONTROLTASK_PRIO, "ControlTask", CONTROLTASK_STACKSIZE);
+  stack_watch_add(DISPLAYTASK_PRIO, "DisplayTask", DISPLAYTASK_STACKSIZE);
+#if !CRUISE_INPUT_IRQ
+  stack_watch_add(BUTTONTASK_PRIO, "ButtonIOTask", BUTTONIOTASK_STACKSIZE);
+  stack_watch_add(SWITCHTASK_PRIO, "SwitchIOTask", SWITCHIOTASK_STACKSIZE);
+#endif
+  stack_watch_add(EXTRALOADTASK_PRIO, "ExtraLoad", EXTRALOAD_STACKSIZE);
+  stack_watch_add(WATCHDOGTASK_PRIO, "Watchdog", WATCHDOG_STACKSIZE);
+  stack_watch_add(OVERLOADTASK_RPIO, "OverloadDetection",
+                  OVERLOADDETECTION_STACKSIZE);
+  stack_watch_add(ShowCPUTASK_RPIO, "ShowCPUUsage", SHOWCPUUSAGE_STACKSIZE);
+#if CRUISE_LOG
+  stack_watch_add(LOGTASK_PRIO, "LogTask", LOGTASK_STACKSIZE);
+#endif
   
 
   printf("All Tasks and Kernel Objects generated!\n");
@@ -1011,12 +1113,12 @@ int main(void) {
 	 StartTask, // Pointer to task code
          NULL,      // Pointer to argument that is
                     // passed to task
-         (void *)&StartTask_Stack[TASK_STACKSIZE-1], // Pointer to top
+         (void *)&StartTask_Stack[STARTTASK_STACKSIZE-1], // Pointer to top
 						     // of task stack 
          STARTTASK_PRIO,
          STARTTASK_PRIO,
          (void *)&StartTask_Stack[0],
-         TASK_STACKSIZE,
+         STARTTASK_STACKSIZE,
          (void *) 0,  
          OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
          
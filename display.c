@@ -0,0 +1,116 @@
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+#include "display.h"
+
+/* Segments gfedcba of a digit, active low */
+#define SEG(d) ((d) == 0 ? 0x40 : (d) == 1 ? 0x79 : (d) == 2 ? 0x24 : \
+                (d) == 3 ? 0x30 : (d) == 4 ? 0x19 : (d) == 5 ? 0x12 : \
+                (d) == 6 ? 0x02 : (d) == 7 ? 0x78 : (d) == 8 ? 0x00 : 0x18)
+#define SEG_MINUS 0x3f
+
+/* Two digits, the tens in bits 13..7 */
+#define SEG2(n)     (SEG((n) / 10) << 7 | SEG((n) % 10))
+#define SEG2_ROW(t) SEG2(10 * (t) + 0), SEG2(10 * (t) + 1), \
+                    SEG2(10 * (t) + 2), SEG2(10 * (t) + 3), \
+                    SEG2(10 * (t) + 4), SEG2(10 * (t) + 5), \
+                    SEG2(10 * (t) + 6), SEG2(10 * (t) + 7), \
+                    SEG2(10 * (t) + 8), SEG2(10 * (t) + 9)
+
+/* 0 to 99 on two displays, folded by the compiler */
+static const alt_u16 display_seg2[100] = {
+  SEG2_ROW(0), SEG2_ROW(1), SEG2_ROW(2), SEG2_ROW(3), SEG2_ROW(4),
+  SEG2_ROW(5), SEG2_ROW(6), SEG2_ROW(7), SEG2_ROW(8), SEG2_ROW(9)
+};
+
+#define HEX_MASK 0x0fffffff     /* Four displays of 7 segments */
+
+enum display_reg {
+  DISPLAY_HEX_LOW,
+  DISPLAY_HEX_HIGH,
+  DISPLAY_RED,
+  DISPLAY_GREEN,
+  DISPLAY_REGS
+};
+
+static const alt_u32 display_base[DISPLAY_REGS] = {
+  DE2_PIO_HEX_LOW28_BASE,
+  DE2_PIO_HEX_HIGH28_BASE,
+  DE2_PIO_REDLED18_BASE,
+  DE2_PIO_GREENLED9_BASE
+};
+
+static alt_u32 display_shadow[DISPLAY_REGS];
+static INT8U   display_dirty;           /* One bit per register */
+
+static void display_set(enum display_reg reg, alt_u32 mask, alt_u32 bits)
+{
+  alt_irq_context context;
+  alt_u32 value;
+
+  context = alt_irq_disable_all();
+  value = (display_shadow[reg] & ~mask) | (bits & mask);
+  if (value != display_shadow[reg]) {
+    display_shadow[reg] = value;
+    display_dirty |= 1 << reg;
+  }
+  alt_irq_enable_all(context);
+}
+
+/*
+ * HEX3 shows 0, HEX2 the sign (0 or -), HEX1..0 the magnitude
+ */
+void display_velocity(INT8S velocity)
+{
+  INT16U tmp = velocity < 0 ? -velocity : velocity;
+
+  if (tmp > 99)
+    tmp = 99;
+  display_set(DISPLAY_HEX_LOW, HEX_MASK,
+              (alt_u32) SEG(0) << 21 |
+              (alt_u32) (velocity < 0 ? SEG_MINUS : SEG(0)) << 14 |
+              display_seg2[tmp]);
+}
+
+/*
+ * HEX5..4 show the target velocity (0 when the cruise control is off),
+ * HEX7..6 show 0
+ */
+void display_target_velocity(INT8U target_vel)
+{
+  if (target_vel > 99)
+    target_vel = 99;
+  display_set(DISPLAY_HEX_HIGH, HEX_MASK,
+              (alt_u32) SEG(0) << 21 | (alt_u32) SEG(0) << 14 |
+              display_seg2[target_vel]);
+}
+
+void display_leds_red(INT32U mask, INT32U bits)
+{
+  display_set(DISPLAY_RED, mask, bits);
+}
+
+void display_leds_green(INT32U mask, INT32U bits)
+{
+  display_set(DISPLAY_GREEN, mask, bits);
+}
+
+/*
+ * Writes the registers changed since the last flush
+ */
+void display_flush(void)
+{
+  alt_irq_context context;
+  alt_u32 value;
+  INT8U reg, dirty;
+
+  for (reg = 0; reg < DISPLAY_REGS; reg++) {
+    context = alt_irq_disable_all();
+    dirty = display_dirty & (1 << reg);
+    display_dirty &= ~(1 << reg);
+    value = display_shadow[reg];
+    alt_irq_enable_all(context);
+    if (dirty)
+      IOWR_ALTERA_AVALON_PIO_DATA(display_base[reg], value);
+  }
+}
@@ -0,0 +1,32 @@
+/*
+ * Display manager: the seven segment displays and the LEDs
+ *
+ * The module owns a shadow of the four output registers (HEX3..0,
+ * HEX7..4, LEDR17..0 and LEDG8..0).  The display_*() calls update the
+ * shadow and mark the register dirty; they never block or touch the PIO
+ * and may be called from tasks and ISRs.  DisplayTask writes the dirty
+ * registers to the PIOs every DISPLAY_PERIOD ms by display_flush(), so a
+ * register is written once per period at most and not at all when its
+ * value did not change.
+ *
+ * Several writers may share a register, each updating only its own bits
+ * (e.g. the switches LEDR9..0 and the position LEDR17..10); the update
+ * is atomic.
+ */
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+/* HEX7..4 and HEX3..0 */
+void display_velocity(INT8S velocity);
+void display_target_velocity(INT8U target_vel);
+
+/* Sets the LEDs of 'mask' to 'bits' */
+void display_leds_red(INT32U mask, INT32U bits);
+void display_leds_green(INT32U mask, INT32U bits);
+
+void display_flush(void);
+
+#endif /* DISPLAY_H_ */
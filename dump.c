@@ -0,0 +1,36 @@
+#include "dump.h"
+#include "sys/alt_irq.h"
+
+static dump_func      dump_funcs[DUMP_MAX];
+static INT8U          dump_num;
+static volatile INT8U dump_requested;
+
+void dump_register(dump_func dump)
+{
+  alt_irq_context context;
+  INT8U i;
+
+  context = alt_irq_disable_all();
+  for (i = 0; i < dump_num && dump_funcs[i] != dump; i++)
+    ;
+  if (i == dump_num && dump_num < DUMP_MAX)
+    dump_funcs[dump_num++] = dump;
+  alt_irq_enable_all(context);
+}
+
+/* Can be called from an ISR; the dumps are printed by dump_poll() */
+void dump_request(void)
+{
+  dump_requested = 1;
+}
+
+void dump_poll(void)
+{
+  INT8U i;
+
+  if (!dump_requested)
+    return;
+  dump_requested = 0;
+  for (i = 0; i < dump_num; i++)
+    dump_funcs[i]();
+}
@@ -0,0 +1,24 @@
+/*
+ * Reports of the instrumentation on request
+ *
+ * Each module that can print a report (task_timing.c, monitor.c,
+ * cpu_account.c, stack_watch.c) registers its dump function once.
+ * dump_request() asks for all of them and can be called from an ISR, e.g.
+ * on KEY0.  The dumps print, so they run in the task that polls:
+ * LogTask, or ShowCPUUsage when the log is off.
+ */
+#ifndef DUMP_H_
+#define DUMP_H_
+
+#include "includes.h"
+
+#define DUMP_MAX 8
+
+typedef void (*dump_func)(void);
+
+/* Registering a dump again has no effect */
+void dump_register(dump_func dump);
+void dump_request(void);
+void dump_poll(void);
+
+#endif /* DUMP_H_ */
@@ -0,0 +1,725 @@
+/*
+ * Stand-in for the Nios II HAL of the DE2 board on the host (Linux).
+ *
+ * - A virtual register file replaces the PIO cores (keys, toggle switches,
+ *   LEDs and seven segment displays).
+ * - A system clock thread raises the timer interrupt every 1/OS_TICKS_PER_SEC
+ *   seconds: it runs alt_alarm callbacks and OSTimeTick() like alt_tick().
+ *   In virtual time mode there is no clock thread; the idle task of the
+ *   port asks for the next tick with something to do and raises it.
+ * - An input PIO raises its interrupt while an enabled bit of its edge
+ *   capture register is set; the handlers run in the tick that applied
+ *   the input change, before the alarms.
+ * - Before main() the HAL initializes the OS, as alt_main() does.
+ * - At the end of the run the interrupts the board takes per minute are
+ *   reported (timer ticks and input PIO interrupts), and the alarm
+ *   callbacks the ticks run.  The ticks that virtual time skips count:
+ *   the system clock of the board ticks every period all the same.
+ *
+ * The run is controlled by environment variables:
+ *
+ *   CRUISE_HOST_STIMULUS=<file>   input changes, one "<ms> keys|switches
+ *                                 <value>" per line; 'keys' is the mask of
+ *                                 pressed KEY buttons ('#' starts a comment)
+ *   CRUISE_HOST_STIMULUS=-        live input changes from stdin, one
+ *                                 "keys|switches <value>" per line, applied
+ *                                 at the next tick (real time only)
+ *   CRUISE_HOST_RECORD=<file>     record the input changes (binary)
+ *   CRUISE_HOST_REPLAY=<file>     apply the input changes of a recording at
+ *                                 the ticks they were recorded at
+ *   CRUISE_HOST_TRACE=<file>      record the samples of the application
+ *                                 (binary, see alt_host_trace_set())
+ *   CRUISE_HOST_DURATION_MS=<ms>  end the run after <ms> milliseconds
+ *   CRUISE_HOST_VIRTUAL=1         run in virtual time, as fast as possible
+ *   CRUISE_HOST_PIO_TRACE=1       log every change of an output PIO
+ *
+ * The recordings are a header - a four character magic, a 16 bit version
+ * and the OS ticks per second - and fixed size records, little endian:
+ *
+ *   "CRIN" input change  32 bit tick, 8 bit port (0: keys, 1: switches),
+ *                        24 bit pins of the PIO (keys active low)
+ *   "CRTR" trace         the records of the sample function that the
+ *                        application registers; the cruise control
+ *                        writes the vehicle state after each update:
+ *                        32 bit number of the update (1, 2, ...), 32 bit
+ *                        position [0.1 m], 16 bit velocity [0.1 m/s],
+ *                        8 bit throttle [0.1 V], 8 bit 0
+ *
+ * In both modes tick 1 is the first tick after OSStart().  A replay gives
+ * the same trace as the recorded run, so two traces can be compared with
+ * cmp(1); for the cruise control the offset less 8 over 12 is the first
+ * update that differs.
+ * The trace holds no ticks, as in real time the response times vary; a
+ * live run and its replay in virtual time match as long as the periodic
+ * tasks kept to their releases.
+ */
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "includes.h"
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_alarm.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_timestamp.h"
+#include "alt_host.h"
+
+#define ALT_HOST_STIMULUS_MAX 1024
+#define ALT_HOST_LIVE_MAX     64        /* Live input changes per tick */
+#define ALT_HOST_REC_VERSION  1
+
+typedef struct alt_host_pio {
+  const char *name;
+  int         input;                 /* Driven by the outside world */
+  int         irq;                   /* Interrupt number, -1: none */
+  alt_u32     regs[4];               /* data, direction, irq mask, edge cap */
+} alt_host_pio;
+
+typedef struct alt_host_stimulus {
+  alt_u32 tick;
+  alt_u32 base;
+  alt_u32 data;
+} alt_host_stimulus;
+
+static alt_host_pio alt_host_pios[ALT_HOST_PIO_NUM] = {
+  { "keys",     1, DE2_PIO_KEYS4_IRQ,     { 0xf } }, /* Active low */
+  { "switches", 1, DE2_PIO_TOGGLES18_IRQ, { 0 } },
+  { "ledr",     0, -1,                    { 0 } },
+  { "ledg",     0, -1,                    { 0 } },
+  { "hex_low",  0, -1,                    { 0 } },
+  { "hex_high", 0, -1,                    { 0 } },
+};
+
+typedef struct alt_host_irq {
+  alt_isr_func handler;
+  void        *context;
+} alt_host_irq;
+
+static alt_host_irq alt_host_irqs[ALT_HOST_IRQ_NUM];
+
+static volatile alt_u32 _alt_nticks;
+static alt_alarm       *alt_alarm_list;
+
+static alt_host_stimulus alt_host_stimuli[ALT_HOST_STIMULUS_MAX];
+static int               alt_host_stimuli_num;
+static int               alt_host_stimuli_next;
+static alt_host_stimulus alt_host_live[ALT_HOST_LIVE_MAX];
+static int               alt_host_live_num;
+static FILE             *alt_host_record;
+static FILE             *alt_host_trace;
+static alt_host_trace_sample alt_host_trace_sample_fn;
+static alt_u32           alt_host_duration_ms;
+static int               alt_host_stop_requested;
+static int               alt_host_pio_trace;
+static int               alt_host_virtual;
+static alt_u32           alt_host_irq_ticks;    /* Interrupts taken */
+static alt_u32           alt_host_irq_inputs;
+static alt_u32           alt_host_alarm_calls;  /* Alarm callbacks run */
+static struct timeval    alt_host_start_time;
+
+static alt_host_pio *alt_host_pio_get(alt_u32 base)
+{
+  alt_u32 n = base / ALT_HOST_PIO_SPAN;
+
+  if (n >= ALT_HOST_PIO_NUM) {
+    fprintf(stderr, "alt_host: no PIO at 0x%04x\n", base);
+    exit(1);
+  }
+  return &alt_host_pios[n];
+}
+
+static alt_u32 alt_host_ms(void)
+{
+  return (alt_u32) ((alt_u64) _alt_nticks * 1000 / OS_TICKS_PER_SEC);
+}
+
+/* First tick at which 'ms' milliseconds have passed */
+static alt_u32 alt_host_ms_to_tick(alt_u32 ms)
+{
+  return (alt_u32) (((alt_u64) ms * OS_TICKS_PER_SEC + 999) / 1000);
+}
+
+/*
+ * PIO register file
+ */
+alt_u32 alt_host_pio_read(alt_u32 base, int reg)
+{
+  return alt_host_pio_get(base)->regs[reg & 3];
+}
+
+void alt_host_pio_write(alt_u32 base, int reg, alt_u32 data)
+{
+  alt_host_pio *pio = alt_host_pio_get(base);
+
+  switch (reg & 3) {
+  case ALTERA_AVALON_PIO_DATA_REG:
+    if (pio->input)
+      return;                        /* Writes to an input port are lost */
+    if (alt_host_pio_trace && pio->regs[0] != data)
+      fprintf(stderr, "[%8u ms] %-8s 0x%08x\n", alt_host_ms(), pio->name,
+              data);
+    pio->regs[0] = data;
+    break;
+  case ALTERA_AVALON_PIO_EDGE_CAP_REG:
+    pio->regs[3] = 0;                /* Any write clears the edge capture */
+    break;
+  default:
+    pio->regs[reg & 3] = data;
+  }
+}
+
+/*
+ * Recordings
+ */
+static void alt_host_put(FILE *fp, alt_u32 value, int bytes)
+{
+  while (bytes-- > 0) {
+    putc(value & 0xff, fp);
+    value >>= 8;
+  }
+}
+
+static alt_u32 alt_host_get(FILE *fp, int bytes, int *eof)
+{
+  alt_u32 value = 0;
+  int i, c;
+
+  for (i = 0; i < bytes; i++) {
+    if ((c = getc(fp)) == EOF)
+      *eof = 1;
+    value |= (alt_u32) (c & 0xff) << (8 * i);
+  }
+  return value;
+}
+
+static FILE *alt_host_rec_create(const char *path, const char *magic)
+{
+  FILE *fp = fopen(path, "wb");
+
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fwrite(magic, 1, 4, fp);
+  alt_host_put(fp, ALT_HOST_REC_VERSION, 2);
+  alt_host_put(fp, OS_TICKS_PER_SEC, 2);
+  return fp;
+}
+
+static void alt_host_rec_close(void)
+{
+  if (alt_host_record != NULL)
+    fclose(alt_host_record);
+  if (alt_host_trace != NULL)
+    fclose(alt_host_trace);
+}
+
+/* Drives the pins of an input PIO, latching the changed bits */
+static void alt_host_pio_drive(alt_u32 base, alt_u32 data)
+{
+  alt_host_pio *pio = alt_host_pio_get(base);
+
+  if (alt_host_record != NULL && pio->regs[0] != data) {
+    alt_host_put(alt_host_record, _alt_nticks, 4);
+    alt_host_put(alt_host_record, base / ALT_HOST_PIO_SPAN, 1);
+    alt_host_put(alt_host_record, data, 3);
+  }
+  pio->regs[3] |= pio->regs[0] ^ data;
+  pio->regs[0]  = data;
+}
+
+/*
+ * Interrupt control: the kernel lock keeps the system clock out.
+ */
+int alt_irq_register(alt_u32 id, void *context, alt_isr_func handler)
+{
+  if (id >= ALT_HOST_IRQ_NUM)
+    return -1;
+  os_host_lock();
+  alt_host_irqs[id].handler = handler;
+  alt_host_irqs[id].context = context;
+  os_host_unlock();
+  return 0;
+}
+
+/* Calls the handlers of the input PIOs whose interrupt is pending */
+static void alt_host_pio_irqs(void)
+{
+  alt_host_pio *pio;
+  alt_host_irq *irq;
+  int i, n;
+
+  for (i = 0; i < ALT_HOST_PIO_NUM; i++) {
+    pio = &alt_host_pios[i];
+    if (pio->irq < 0)
+      continue;
+    irq = &alt_host_irqs[pio->irq];
+    for (n = 0; irq->handler != NULL && (pio->regs[2] & pio->regs[3]); n++) {
+      if (n == 16) {
+        fprintf(stderr, "alt_host: IRQ %d is not acknowledged, masked\n",
+                pio->irq);
+        pio->regs[2] = 0;
+        break;
+      }
+      irq->handler(irq->context, pio->irq);
+      alt_host_irq_inputs++;
+    }
+  }
+}
+
+alt_irq_context alt_irq_disable_all(void)
+{
+  os_host_lock();
+  return 0;
+}
+
+void alt_irq_enable_all(alt_irq_context context)
+{
+  (void) context;
+  os_host_unlock();
+}
+
+/*
+ * Alarms
+ */
+alt_u32 alt_ticks_per_second(void)
+{
+  return OS_TICKS_PER_SEC;
+}
+
+alt_u32 alt_nticks(void)
+{
+  return _alt_nticks;
+}
+
+int alt_alarm_start(alt_alarm *alarm, alt_u32 nticks,
+                    alt_u32 (*callback)(void *context), void *context)
+{
+  if (alarm == NULL || callback == NULL)
+    return -1;
+  os_host_lock();
+  alarm->time     = _alt_nticks + nticks + 1;
+  alarm->callback = callback;
+  alarm->context  = context;
+  if (!alarm->armed) {
+    alarm->next    = alt_alarm_list;
+    alt_alarm_list = alarm;
+    alarm->armed   = 1;
+  }
+  os_host_unlock();
+  return 0;
+}
+
+void alt_alarm_stop(alt_alarm *alarm)
+{
+  alt_alarm **pp;
+
+  os_host_lock();
+  for (pp = &alt_alarm_list; *pp != NULL; pp = &(*pp)->next) {
+    if (*pp == alarm) {
+      *pp = alarm->next;
+      alarm->armed = 0;
+      break;
+    }
+  }
+  os_host_unlock();
+}
+
+/*
+ * Timestamp timer, counting nanoseconds.  In real time mode it is the
+ * host's monotonic clock.  In virtual time mode it is the virtual time of
+ * the last tick plus the host time that passed since then (at most one
+ * tick), so intervals between ticks are simulated and the work within a
+ * tick is measured.
+ */
+static struct timespec alt_timestamp_base;
+static alt_u64         alt_timestamp_tick_ns;   /* Host time of the last tick */
+
+static alt_u64 alt_host_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (alt_u64) (now.tv_sec - alt_timestamp_base.tv_sec) * 1000000000u +
+         now.tv_nsec - alt_timestamp_base.tv_nsec;
+}
+
+int alt_timestamp_start(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &alt_timestamp_base);
+  alt_timestamp_tick_ns = 0;
+  return 0;
+}
+
+alt_timestamp_type alt_timestamp(void)
+{
+  alt_u64 tick_ns = 1000000000u / OS_TICKS_PER_SEC;
+  alt_u64 in_tick;
+
+  if (!alt_host_virtual)
+    return alt_host_ns();
+  in_tick = alt_host_ns() - alt_timestamp_tick_ns;
+  if (in_tick >= tick_ns)
+    in_tick = tick_ns - 1;
+  return (alt_u64) _alt_nticks * tick_ns + in_tick;
+}
+
+alt_u32 alt_timestamp_freq(void)
+{
+  return 1000000000u;
+}
+
+/*
+ * System clock
+ */
+static void alt_host_apply_stimuli(void)
+{
+  int i;
+
+  while (alt_host_stimuli_next < alt_host_stimuli_num &&
+         alt_host_stimuli[alt_host_stimuli_next].tick <= _alt_nticks) {
+    alt_host_stimulus *s = &alt_host_stimuli[alt_host_stimuli_next++];
+    alt_host_pio_drive(s->base, s->data);
+  }
+  for (i = 0; i < alt_host_live_num; i++)
+    alt_host_pio_drive(alt_host_live[i].base, alt_host_live[i].data);
+  alt_host_live_num = 0;
+}
+
+/* Same work as alt_tick() of the HAL, called with interrupts disabled */
+static void alt_tick(void)
+{
+  alt_alarm **pp = &alt_alarm_list;
+  alt_u32 next;
+
+  _alt_nticks++;
+  alt_timestamp_tick_ns = alt_host_ns();
+  alt_host_apply_stimuli();
+  alt_host_pio_irqs();
+
+  while (*pp != NULL) {
+    alt_alarm *alarm = *pp;
+    if (alarm->time <= _alt_nticks) {
+      alt_host_alarm_calls++;
+      next = alarm->callback(alarm->context);
+      if (next == 0) {
+        *pp = alarm->next;
+        alarm->armed = 0;
+        continue;
+      }
+      alarm->time += next;
+    }
+    pp = &alarm->next;
+  }
+  OSTimeTick();
+}
+
+/* The timer interrupt of the system clock */
+void alt_host_clock_tick(void)
+{
+  alt_host_irq_ticks++;
+  OSIntEnter();
+  alt_tick();
+  OSIntExit();
+
+  if (alt_host_duration_ms != 0 && alt_host_ms() >= alt_host_duration_ms) {
+    if (!alt_host_stop_requested) {
+      alt_host_stop_requested = 1;
+      os_host_stop();
+    } else if (alt_host_ms() > alt_host_duration_ms + 1000) {
+      /* The CPU never went idle: stop anyway */
+      fflush(stdout);
+      _exit(0);
+    }
+  }
+}
+
+INT32U alt_host_clock_ticks(void)
+{
+  return _alt_nticks;
+}
+
+/*
+ * Ticks until the next tick with work for the HAL - an alarm, an input
+ * change or the end of the run - or 0 if there is none.
+ */
+INT32U alt_host_clock_ticks_to_event(void)
+{
+  alt_alarm *alarm;
+  alt_u32 next = 0, t;
+
+  for (alarm = alt_alarm_list; alarm != NULL; alarm = alarm->next)
+    if (next == 0 || alarm->time < next)
+      next = alarm->time;
+  if (alt_host_stimuli_next < alt_host_stimuli_num) {
+    t = alt_host_stimuli[alt_host_stimuli_next].tick;
+    if (next == 0 || t < next)
+      next = t;
+  }
+  if (alt_host_duration_ms != 0 && !alt_host_stop_requested) {
+    t = alt_host_ms_to_tick(alt_host_duration_ms);
+    if (next == 0 || t < next)
+      next = t;
+  }
+  if (next == 0)
+    return 0;
+  return next > _alt_nticks ? next - _alt_nticks : 1;
+}
+
+/*
+ * Lets 'ticks' ticks pass in which the HAL has nothing to do; the board
+ * takes them as interrupts all the same
+ */
+void alt_host_clock_skip(INT32U ticks)
+{
+  _alt_nticks += ticks;
+  alt_host_irq_ticks += ticks;
+}
+
+static void *alt_host_sys_clk(void *arg)
+{
+  struct timespec next;
+  long period_ns = 1000000000L / OS_TICKS_PER_SEC;
+
+  (void) arg;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (;;) {
+    next.tv_nsec += period_ns;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0)
+      ;
+    /* Tick 1 is the first after OSStart(), as in virtual time */
+    if (OSRunning)
+      alt_host_clock_tick();
+  }
+  return NULL;
+}
+
+void alt_host_trace_set(alt_host_trace_sample sample)
+{
+  alt_host_trace_sample_fn = sample;
+}
+
+/*
+ * Called by the idle task of the port.  Every task is blocked, so no
+ * update of the sampled state is in progress.
+ */
+void alt_host_idle(void)
+{
+  unsigned char buf[ALT_HOST_TRACE_MAX];
+  size_t len = sizeof(buf);
+
+  if (alt_host_trace == NULL || alt_host_trace_sample_fn == NULL)
+    return;
+  alt_host_trace_sample_fn(buf, &len);
+  if (len > 0)
+    fwrite(buf, 1, len < sizeof(buf) ? len : sizeof(buf), alt_host_trace);
+}
+
+static void alt_host_report_speed(void)
+{
+  struct timeval now;
+  double wall;
+
+  gettimeofday(&now, NULL);
+  wall = (now.tv_sec - alt_host_start_time.tv_sec) +
+         (now.tv_usec - alt_host_start_time.tv_usec) / 1e6;
+  fprintf(stderr, "alt_host: %.3f s of virtual time in %.3f s\n",
+          _alt_nticks / (double) OS_TICKS_PER_SEC, wall);
+}
+
+static void alt_host_report_irqs(void)
+{
+  alt_u32 ms = alt_host_ms();
+
+  if (ms == 0)
+    return;
+  fprintf(stderr, "alt_host: %lu interrupts per minute "
+          "(%lu ticks, %lu inputs in %lu ms), %lu alarm callbacks per minute\n",
+          (unsigned long) ((alt_u64) (alt_host_irq_ticks + alt_host_irq_inputs)
+                           * 60000 / ms),
+          (unsigned long) alt_host_irq_ticks,
+          (unsigned long) alt_host_irq_inputs, (unsigned long) ms,
+          (unsigned long) ((alt_u64) alt_host_alarm_calls * 60000 / ms));
+}
+
+/*
+ * Start-up
+ */
+
+/* The pins of 'port' for 'value', 0 for an unknown port */
+static int alt_host_parse_port(const char *port, unsigned long value,
+                               alt_host_stimulus *s)
+{
+  if (strcmp(port, "keys") == 0) {
+    s->base = DE2_PIO_KEYS4_BASE;
+    s->data = ~value & 0xf;
+  } else if (strcmp(port, "switches") == 0) {
+    s->base = DE2_PIO_TOGGLES18_BASE;
+    s->data = value & 0x3ffff;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+static void alt_host_load_stimuli(const char *path)
+{
+  FILE *fp = fopen(path, "r");
+  char line[256], port[32];
+  unsigned long ms, data;
+
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char *hash = strchr(line, '#');
+    alt_host_stimulus *s;
+
+    if (hash != NULL)
+      *hash = '\0';
+    if (sscanf(line, "%lu %31s %li", &ms, port, (long *) &data) != 3)
+      continue;
+    if (alt_host_stimuli_num == ALT_HOST_STIMULUS_MAX) {
+      fprintf(stderr, "%s: more than %d input changes\n", path,
+              ALT_HOST_STIMULUS_MAX);
+      exit(1);
+    }
+    s = &alt_host_stimuli[alt_host_stimuli_num];
+    s->tick = alt_host_ms_to_tick(ms);
+    if (!alt_host_parse_port(port, data, s)) {
+      fprintf(stderr, "%s: unknown port '%s'\n", path, port);
+      exit(1);
+    }
+    if (alt_host_stimuli_num > 0 && s[-1].tick > s->tick) {
+      fprintf(stderr, "%s: input changes must be in time order\n", path);
+      exit(1);
+    }
+    alt_host_stimuli_num++;
+  }
+  fclose(fp);
+}
+
+static void alt_host_load_replay(const char *path)
+{
+  FILE *fp = fopen(path, "rb");
+  char magic[4];
+  alt_host_stimulus *s;
+  alt_u32 port;
+  int eof = 0;
+
+  if (fp == NULL) {
+    perror(path);
+    exit(1);
+  }
+  if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, "CRIN", 4) != 0 ||
+      alt_host_get(fp, 2, &eof) != ALT_HOST_REC_VERSION) {
+    fprintf(stderr, "%s: not an input recording\n", path);
+    exit(1);
+  }
+  if (alt_host_get(fp, 2, &eof) != OS_TICKS_PER_SEC) {
+    fprintf(stderr, "%s: recorded at another OS_TICKS_PER_SEC\n", path);
+    exit(1);
+  }
+  for (;;) {
+    s = &alt_host_stimuli[alt_host_stimuli_num];
+    s->tick = alt_host_get(fp, 4, &eof);
+    port    = alt_host_get(fp, 1, &eof);
+    s->data = alt_host_get(fp, 3, &eof);
+    if (eof)
+      break;
+    if (port >= ALT_HOST_PIO_NUM || !alt_host_pios[port].input) {
+      fprintf(stderr, "%s: no input PIO %lu\n", path, (unsigned long) port);
+      exit(1);
+    }
+    s->base = port * ALT_HOST_PIO_SPAN;
+    if (++alt_host_stimuli_num == ALT_HOST_STIMULUS_MAX) {
+      fprintf(stderr, "%s: more than %d input changes\n", path,
+              ALT_HOST_STIMULUS_MAX);
+      exit(1);
+    }
+  }
+  fclose(fp);
+}
+
+/* Reads live input changes from stdin and queues them for the next tick */
+static void *alt_host_live_input(void *arg)
+{
+  char line[256], port[32];
+  unsigned long data;
+  alt_host_stimulus s;
+
+  (void) arg;
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    if (sscanf(line, "%31s %li", port, (long *) &data) != 2)
+      continue;
+    if (!alt_host_parse_port(port, data, &s)) {
+      fprintf(stderr, "stdin: unknown port '%s'\n", port);
+      continue;
+    }
+    os_host_lock();
+    if (alt_host_live_num < ALT_HOST_LIVE_MAX)
+      alt_host_live[alt_host_live_num++] = s;
+    os_host_unlock();
+  }
+  return NULL;
+}
+
+__attribute__((constructor))
+static void alt_host_main(void)
+{
+  pthread_t thread;
+  const char *env, *stimulus;
+  int live;
+
+  stimulus = getenv("CRUISE_HOST_STIMULUS");
+  live = stimulus != NULL && strcmp(stimulus, "-") == 0;
+  if (stimulus != NULL && !live)
+    alt_host_load_stimuli(stimulus);
+  if ((env = getenv("CRUISE_HOST_REPLAY")) != NULL) {
+    if (stimulus != NULL) {
+      fprintf(stderr, "alt_host: CRUISE_HOST_REPLAY with a stimulus\n");
+      exit(1);
+    }
+    alt_host_load_replay(env);
+  }
+  if ((env = getenv("CRUISE_HOST_RECORD")) != NULL)
+    alt_host_record = alt_host_rec_create(env, "CRIN");
+  if ((env = getenv("CRUISE_HOST_TRACE")) != NULL)
+    alt_host_trace = alt_host_rec_create(env, "CRTR");
+  if ((env = getenv("CRUISE_HOST_DURATION_MS")) != NULL)
+    alt_host_duration_ms = strtoul(env, NULL, 0);
+  if ((env = getenv("CRUISE_HOST_PIO_TRACE")) != NULL)
+    alt_host_pio_trace = atoi(env);
+  if ((env = getenv("CRUISE_HOST_VIRTUAL")) != NULL)
+    alt_host_virtual = atoi(env);
+
+  atexit(alt_host_report_irqs);
+  atexit(alt_host_rec_close);
+  if (alt_host_virtual) {
+    if (live) {
+      fprintf(stderr, "alt_host: live input needs real time\n");
+      exit(1);
+    }
+    os_host_set_virtual();
+    gettimeofday(&alt_host_start_time, NULL);
+    atexit(alt_host_report_speed);
+    OSInit();
+    return;
+  }
+  OSInit();
+  if (pthread_create(&thread, NULL, alt_host_sys_clk, NULL) != 0) {
+    fprintf(stderr, "alt_host: cannot start the system clock\n");
+    exit(1);
+  }
+  if (live && pthread_create(&thread, NULL, alt_host_live_input, NULL) != 0) {
+    fprintf(stderr, "alt_host: cannot start the live input\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,23 @@
+/*
+ * Host-only extensions of the HAL stand-in (alt_host.c)
+ *
+ * Code that uses them checks ALT_HOST, which the host system.h defines.
+ */
+#ifndef ALT_HOST_H_
+#define ALT_HOST_H_
+
+#include <stddef.h>
+
+#define ALT_HOST_TRACE_MAX 64   /* Bytes of a trace record at most */
+
+/*
+ * Sample of the CRUISE_HOST_TRACE file, called by the idle task when all
+ * tasks are blocked: writes a record to 'buf' and its size to '*len',
+ * which holds the size of 'buf' on entry, or sets '*len' to 0 if nothing
+ * changed since the last record
+ */
+typedef void (*alt_host_trace_sample)(void *buf, size_t *len);
+
+void alt_host_trace_set(alt_host_trace_sample sample);
+
+#endif /* ALT_HOST_H_ */
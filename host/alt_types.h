@@ -0,0 +1,16 @@
+/*
+ * Host (Linux) stand-in for the Nios II HAL 'alt_types.h'.
+ */
+#ifndef __ALT_TYPES_H__
+#define __ALT_TYPES_H__
+
+typedef signed char    alt_8;
+typedef unsigned char  alt_u8;
+typedef signed short   alt_16;
+typedef unsigned short alt_u16;
+typedef signed int     alt_32;
+typedef unsigned int   alt_u32;
+typedef long long      alt_64;
+typedef unsigned long long alt_u64;
+
+#endif /* __ALT_TYPES_H__ */
@@ -0,0 +1,39 @@
+/*
+ * Host (Linux) stand-in for 'altera_avalon_pio_regs.h'.
+ *
+ * Register accesses go to the virtual PIO register file of alt_host.c.
+ */
+#ifndef __ALTERA_AVALON_PIO_REGS_H__
+#define __ALTERA_AVALON_PIO_REGS_H__
+
+#include "alt_types.h"
+
+#define ALTERA_AVALON_PIO_DATA_REG       0
+#define ALTERA_AVALON_PIO_DIRECTION_REG  1
+#define ALTERA_AVALON_PIO_IRQ_MASK_REG   2
+#define ALTERA_AVALON_PIO_EDGE_CAP_REG   3
+
+alt_u32 alt_host_pio_read(alt_u32 base, int reg);
+void    alt_host_pio_write(alt_u32 base, int reg, alt_u32 data);
+
+#define IORD_ALTERA_AVALON_PIO_DATA(base) \
+        alt_host_pio_read(base, ALTERA_AVALON_PIO_DATA_REG)
+#define IOWR_ALTERA_AVALON_PIO_DATA(base, data) \
+        alt_host_pio_write(base, ALTERA_AVALON_PIO_DATA_REG, data)
+
+#define IORD_ALTERA_AVALON_PIO_DIRECTION(base) \
+        alt_host_pio_read(base, ALTERA_AVALON_PIO_DIRECTION_REG)
+#define IOWR_ALTERA_AVALON_PIO_DIRECTION(base, data) \
+        alt_host_pio_write(base, ALTERA_AVALON_PIO_DIRECTION_REG, data)
+
+#define IORD_ALTERA_AVALON_PIO_IRQ_MASK(base) \
+        alt_host_pio_read(base, ALTERA_AVALON_PIO_IRQ_MASK_REG)
+#define IOWR_ALTERA_AVALON_PIO_IRQ_MASK(base, data) \
+        alt_host_pio_write(base, ALTERA_AVALON_PIO_IRQ_MASK_REG, data)
+
+#define IORD_ALTERA_AVALON_PIO_EDGE_CAP(base) \
+        alt_host_pio_read(base, ALTERA_AVALON_PIO_EDGE_CAP_REG)
+#define IOWR_ALTERA_AVALON_PIO_EDGE_CAP(base, data) \
+        alt_host_pio_write(base, ALTERA_AVALON_PIO_EDGE_CAP_REG, data)
+
+#endif /* __ALTERA_AVALON_PIO_REGS_H__ */
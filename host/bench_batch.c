@@ -0,0 +1,235 @@
+/*
+ * Benchmark of the batch stepping of vehicle_batch.c (host only)
+ *
+ * A batch of 1k, 100k and 10M vehicles starts from a pseudo random state:
+ * anywhere on the track of TRACK_TABLE, -5 to 40 m/s with some at rest,
+ * a throttle of 0 to 80 and one vehicle in 16 braking.  Each kernel the
+ * CPU supports advances the batch by BENCH_TOTAL vehicle-steps in all
+ * (fewer steps for a larger batch) from the same state, and the table
+ * gives the time and the vehicle-steps per second against the scalar
+ * kernel.  The state each kernel ends in must be the one of the scalar
+ * kernel, bit for bit, and the scalar kernel must agree with
+ * vehicle_acceleration_drag(), vehicle_plant_step() and track_find() for
+ * the first BENCH_CHECK vehicles over BENCH_CHECK_STEPS steps; the
+ * benchmark fails otherwise.
+ *
+ *   bench_batch [-n vehicles] [-t total steps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "vehicle_batch.h"
+#include "track.h"
+
+#define BENCH_TOTAL  200000000.0        /* Vehicle-steps per kernel */
+#define BENCH_CHECK  1000               /* Vehicles checked per step */
+#define BENCH_CHECK_STEPS 1000
+
+static const INT32U bench_sizes[] = { 1000, 100000, 10000000 };
+#define BENCH_SIZES (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+/* splitmix64 */
+static unsigned long long bench_next(unsigned long long *state)
+{
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static long bench_uniform(unsigned long long *state, long min, long max)
+{
+  return min + (long) (bench_next(state) % (unsigned long long) (max - min + 1));
+}
+
+static double bench_now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void bench_init(struct vehicle_batch *b,
+                       const struct vehicle_batch_track *t)
+{
+  unsigned long long state = 1;
+  INT32U i;
+
+  for (i = 0; i < b->num; i++) {
+    b->position[i] = bench_uniform(&state, 0, track_length - 1);
+    b->position_frac[i] = bench_uniform(&state, 0, 999);
+    b->velocity[i] = bench_uniform(&state, -50, 400);
+    b->velocity_frac[i] = bench_uniform(&state, 0, 999);
+    if (b->velocity[i] < 0)
+      b->velocity_frac[i] = -b->velocity_frac[i];
+    if (bench_uniform(&state, 0, 15) == 0)
+      b->velocity[i] = b->velocity_frac[i] = 0;
+    b->throttle[i] = bench_uniform(&state, 0, 80);
+    b->brake[i] = bench_uniform(&state, 0, 15) == 0;
+  }
+  vehicle_batch_locate(b, t);
+}
+
+static void bench_copy(struct vehicle_batch *dst, const struct vehicle_batch *src)
+{
+  INT32U n = src->num;
+
+  memcpy(dst->position, src->position, n * sizeof(*src->position));
+  memcpy(dst->velocity, src->velocity, n * sizeof(*src->velocity));
+  memcpy(dst->position_frac, src->position_frac,
+         n * sizeof(*src->position_frac));
+  memcpy(dst->velocity_frac, src->velocity_frac,
+         n * sizeof(*src->velocity_frac));
+  memcpy(dst->segment, src->segment, n * sizeof(*src->segment));
+  memcpy(dst->throttle, src->throttle, n * sizeof(*src->throttle));
+  memcpy(dst->brake, src->brake, n * sizeof(*src->brake));
+}
+
+static int bench_same(const struct vehicle_batch *a,
+                      const struct vehicle_batch *b)
+{
+  INT32U n = a->num;
+
+  return memcmp(a->position, b->position, n * sizeof(*a->position)) == 0 &&
+         memcmp(a->velocity, b->velocity, n * sizeof(*a->velocity)) == 0 &&
+         memcmp(a->position_frac, b->position_frac,
+                n * sizeof(*a->position_frac)) == 0 &&
+         memcmp(a->velocity_frac, b->velocity_frac,
+                n * sizeof(*a->velocity_frac)) == 0 &&
+         memcmp(a->segment, b->segment, n * sizeof(*a->segment)) == 0;
+}
+
+/*
+ * Steps the first vehicles of 'b' one by one as VehicleTask does, next to
+ * a batch of them with the scalar kernel; returns the number of the first
+ * vehicle that differs or -1
+ */
+static long bench_reference(const struct vehicle_batch *b,
+                            const struct vehicle_batch_track *t, INT32U steps)
+{
+  static struct vehicle_plant p[BENCH_CHECK];
+  static INT16U segment[BENCH_CHECK];
+  struct vehicle_batch s;
+  INT32U n = b->num < BENCH_CHECK ? b->num : BENCH_CHECK, i, k;
+  long bad = -1;
+
+  if (vehicle_batch_alloc(&s, n) < 0)
+    return 0;
+  for (i = 0; i < n; i++) {
+    s.position[i] = b->position[i];
+    s.velocity[i] = b->velocity[i];
+    s.position_frac[i] = b->position_frac[i];
+    s.velocity_frac[i] = b->velocity_frac[i];
+    s.segment[i] = segment[i] = b->segment[i];
+    s.throttle[i] = b->throttle[i];
+    s.brake[i] = b->brake[i];
+    p[i] = (struct vehicle_plant) { b->position[i], b->velocity[i],
+                                    b->position_frac[i], b->velocity_frac[i] };
+  }
+  for (k = 0; k < steps && bad < 0; k++) {
+    vehicle_batch_step(&s, t, VEHICLE_PERIOD, VEHICLE_BATCH_SCALAR);
+    for (i = 0; i < n; i++) {
+      vehicle_plant_step(&p[i], vehicle_acceleration_drag(&p[i],
+                                  s.throttle[i], t->slope[segment[i]],
+                                  &t->drag),
+                         s.brake[i] ? on : off, VEHICLE_PERIOD);
+      segment[i] = track_find(p[i].position, segment[i]);
+      if (bad < 0 && (p[i].position != s.position[i] ||
+                      p[i].velocity != s.velocity[i] ||
+                      p[i].position_frac != s.position_frac[i] ||
+                      p[i].velocity_frac != s.velocity_frac[i] ||
+                      segment[i] != s.segment[i]))
+        bad = i;
+    }
+  }
+  vehicle_batch_free(&s);
+  return bad;
+}
+
+int main(int argc, char *argv[])
+{
+  struct vehicle_batch_track t;
+  struct vehicle_batch start, ref, run;
+  struct vehicle_drag drag = { VEHICLE_WIND_DIV, VEHICLE_ROLLING };
+  enum vehicle_batch_kernel k, best = vehicle_batch_best();
+  double total = BENCH_TOTAL, t0, time, t_scalar = 0;
+  INT32U sizes[BENCH_SIZES], num = 0, steps, n, j;
+  const char *result;
+  long bad;
+  int opt, failed = 0;
+
+  while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+    switch (opt) {
+    case 'n': num = strtoul(optarg, NULL, 0); break;
+    case 't': total = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-n vehicles] [-t total steps]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (vehicle_batch_track_init(&t, NULL, &drag) < 0) {
+    fprintf(stderr, "%s: more than %d track segments\n", argv[0],
+            VEHICLE_BATCH_SEGMENTS_MAX);
+    return 1;
+  }
+  memcpy(sizes, bench_sizes, sizeof(sizes));
+  n = num > 0 ? 1 : BENCH_SIZES;
+  if (num > 0)
+    sizes[0] = num;
+
+  printf("Batch stepping, %lu segments (%d search steps), %d ms steps, "
+         "best kernel %s\n", (unsigned long) track_segments, (int) t.steps,
+         VEHICLE_PERIOD, vehicle_batch_name(best));
+  printf("%9s %7s %-7s %8s %12s %8s %s\n", "vehicles", "steps", "kernel",
+         "time_s", "steps/s", "speed-up", "result");
+  for (j = 0; j < n; j++) {
+    steps = (INT32U) (total / sizes[j]);
+    if (steps < 1)
+      steps = 1;
+    if (vehicle_batch_alloc(&start, sizes[j]) < 0 ||
+        vehicle_batch_alloc(&ref, sizes[j]) < 0 ||
+        vehicle_batch_alloc(&run, sizes[j]) < 0) {
+      fprintf(stderr, "%s: out of memory for %lu vehicles\n", argv[0],
+              (unsigned long) sizes[j]);
+      return 1;
+    }
+    bench_init(&start, &t);
+
+    bad = bench_reference(&start, &t, BENCH_CHECK_STEPS);
+    if (bad >= 0) {
+      printf("vehicle %ld: scalar kernel differs from vehicle_plant_step\n",
+             bad);
+      failed = 1;
+    }
+    for (k = VEHICLE_BATCH_SCALAR; k <= best; k++) {
+      bench_copy(&run, &start);
+      t0 = bench_now();
+      for (num = 0; num < steps; num++)
+        vehicle_batch_step(&run, &t, VEHICLE_PERIOD, k);
+      time = bench_now() - t0;
+      if (k == VEHICLE_BATCH_SCALAR) {
+        t_scalar = time;
+        bench_copy(&ref, &run);
+        result = "reference";
+      } else if (bench_same(&run, &ref))
+        result = "identical";
+      else {
+        result = "DIFFERS";
+        failed = 1;
+      }
+      printf("%9lu %7lu %-7s %8.3f %12.4g %8.2f %s\n",
+             (unsigned long) sizes[j], (unsigned long) steps,
+             vehicle_batch_name(k), time, (double) sizes[j] * steps / time,
+             t_scalar / time, result);
+    }
+    vehicle_batch_free(&start);
+    vehicle_batch_free(&ref);
+    vehicle_batch_free(&run);
+  }
+  return failed;
+}
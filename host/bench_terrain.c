@@ -0,0 +1,137 @@
+/*
+ * Benchmark of the cruise controllers over the terrain (host only)
+ *
+ * Drives the track of TRACK_TABLE with the closed loop of sim.c with the
+ * controller of CRUISE_CONTROLLER: the PID controller (0), the slope
+ * feedforward plus PID correction (1) or the look-ahead controller (2,
+ * MPC_* of cruise_config.h), at each target velocity of
+ * terrain_target[]; make terrain builds and runs it for each.  The
+ * vehicle starts at the target with the cruise control engaged.  For each
+ * slope change the time until the velocity stays within SIM_BAND of the
+ * target is counted in control cycles; the table gives its mean and
+ * maximum over the changes, the largest deviation from the target, the
+ * mean change of the throttle per control step and the time at full
+ * throttle.
+ *
+ *   bench_terrain [-l laps] [-k kp,ki,kd] [-f kp,ki,kd]
+ *
+ * -k sets the gains of the PID controller, -f those of the correction of
+ * the feedforward controller, both per PID_TUNED_PERIOD; each applies to
+ * its controller only.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+/* Cruise targets, 0.1 m/s */
+static const INT16S terrain_target[] = { 200, 250, 300, 350 };
+#define TERRAIN_TARGETS (sizeof(terrain_target) / sizeof(terrain_target[0]))
+
+static const char *terrain_name[] = { "pid", "feedforward", "mpc" };
+#define TERRAIN_NAME terrain_name[CRUISE_CONTROLLER]
+
+struct terrain_sum {
+  INT32U settle_ms, changes, settle_max_ms, max_error, effort, steps;
+  INT32U saturated_ms, unfinished;
+};
+
+static void terrain_print(const char *name, const char *target,
+                          const struct terrain_sum *t)
+{
+  printf("%-12s %6s %7lu %9.1f %9.1f %9.1f %7.2f %8.1f%s\n", name, target,
+         (unsigned long) t->changes,
+         t->changes ? (double) t->settle_ms / CONTROL_PERIOD / t->changes : 0,
+         (double) t->settle_max_ms / CONTROL_PERIOD, t->max_error / 10.0,
+         t->steps ? t->effort / 10.0 / t->steps : 0, t->saturated_ms / 1000.0,
+         t->unfinished ? "  (laps not driven)" : "");
+}
+
+static int terrain_gains(const char *arg, double *k)
+{
+  return sscanf(arg, "%lf,%lf,%lf", &k[0], &k[1], &k[2]) == 3;
+}
+
+int main(int argc, char *argv[])
+{
+  double k[2][3] = { { PID_KP, PID_KI, PID_KD },
+                     { PID_FF_KP, PID_FF_KI, PID_FF_KD } };
+  struct sim_scenario sc = { { VEHICLE_WIND_DIV, VEHICLE_ROLLING } };
+  struct sim_result r;
+  struct terrain_sum t, all;
+  struct sim_gains gains = SIM_GAINS;
+  char target[8];
+  int laps = 2, opt;
+  unsigned i;
+
+  while ((opt = getopt(argc, argv, "l:k:f:")) != -1) {
+    switch (opt) {
+    case 'l': laps = atoi(optarg); break;
+    case 'k':
+    case 'f':
+      if (!terrain_gains(optarg, k[opt == 'f'])) {
+        fprintf(stderr, "%s: -%c kp,ki,kd\n", argv[0], opt);
+        return 1;
+      }
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-l laps] [-k kp,ki,kd] [-f kp,ki,kd]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (laps < 1) {
+    fprintf(stderr, "%s: at least 1 lap\n", argv[0]);
+    return 1;
+  }
+
+  printf("Track of %d segments, %lu.%lu km, %d laps; control %d ms\n",
+         track_segments, (unsigned long) track_length / 10000,
+         (unsigned long) track_length / 1000 % 10, laps, CONTROL_PERIOD);
+#if CRUISE_CONTROLLER == 2
+  printf("%-12s horizon %d x %d ms in %d blocks, Q %d R %d\n", TERRAIN_NAME,
+         MPC_HORIZON, CONTROL_PERIOD, MPC_BLOCKS, MPC_Q, MPC_R);
+#else
+  printf("%-12s Kp %g Ki %g Kd %g\n", TERRAIN_NAME, k[CRUISE_CONTROLLER][0],
+         k[CRUISE_CONTROLLER][1], k[CRUISE_CONTROLLER][2]);
+  gains.kp = k[CRUISE_CONTROLLER][0];
+  gains.ki = k[CRUISE_CONTROLLER][1];
+  gains.kd = k[CRUISE_CONTROLLER][2];
+#endif
+  printf("\n%-12s %6s %7s %9s %9s %9s %7s %8s\n", "controller", "m/s",
+         "changes", "settle", "settle_max", "err_m/s", "effort", "full_s");
+
+  all = (struct terrain_sum) { 0 };
+  for (i = 0; i < TERRAIN_TARGETS; i++) {
+    sc.velocity = terrain_target[i];
+    sc.distance = (INT32U) laps * track_length;
+    sc.max_ms   = 3 * (sc.distance / terrain_target[i] * 1000);
+    sim_run(&gains, &sc, &r);
+
+    t.settle_ms     = r.settle_ms;
+    t.changes       = r.changes;
+    t.settle_max_ms = r.settle_max_ms;
+    t.max_error     = r.max_error;
+    t.effort        = r.effort;
+    t.steps         = r.control_steps;
+    t.saturated_ms  = r.saturated_ms;
+    t.unfinished    = !r.finished;
+    sprintf(target, "%d", terrain_target[i] / 10);
+    terrain_print(TERRAIN_NAME, target, &t);
+
+    all.settle_ms    += t.settle_ms;
+    all.changes      += t.changes;
+    all.effort       += t.effort;
+    all.steps        += t.steps;
+    all.saturated_ms += t.saturated_ms;
+    all.unfinished   += t.unfinished;
+    if (t.settle_max_ms > all.settle_max_ms)
+      all.settle_max_ms = t.settle_max_ms;
+    if (t.max_error > all.max_error)
+      all.max_error = t.max_error;
+  }
+  terrain_print(TERRAIN_NAME, "all", &all);
+  printf("\nsettle in control cycles after a slope change\n");
+  return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Fleet runner: many independent vehicles with their cruise control in
+ * one process (host only)
+ *
+ * Each vehicle is a struct cruise_vehicle and a struct cruise_controller
+ * (cruise.h), stepped with the functions VehicleTask and ControlTask call,
+ * every VEHICLE_PERIOD and CONTROL_PERIOD.  A vehicle drives the scenario
+ * of drive.stim with its own start position and timing, drawn from the
+ * seed and its number: engine on, gas, top gear, then it releases the gas
+ * pedal and holds the cruise control key until it brakes.  The vehicles
+ * are spread over a pool of threads (sim_parallel); the results do not
+ * depend on the number of threads, which the digest shows.
+ *
+ *   fleet_sim [-n vehicles] [-j threads] [-t seconds] [-s seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "cruise.h"
+
+struct fleet_vehicle {
+  INT16U target;                /* Cruise velocity, 0.1 m/s, 0: none */
+  INT16S velocity;              /* At the end */
+  INT32U position;
+};
+
+struct fleet {
+  unsigned long long seed;
+  INT32U duration_ms;
+  struct fleet_vehicle *v;
+};
+
+/* Inputs of the drive at 'ms' */
+static void fleet_inputs(struct input_snapshot *in, INT32U ms, INT32U release,
+                         INT32U brake)
+{
+  memset(in, 0, sizeof(*in));
+  in->engine        = ms >= 1000 ? on : off;
+  in->top_gear      = ms >= 12000 ? on : off;
+  in->gas_pedal     = ms >= 2000 && ms < release ? on : off;
+  in->cruise_button = ms >= release + 500 && ms < brake ? on : off;
+  in->brake_pedal   = ms >= brake && ms < brake + 5000 ? on : off;
+}
+
+static void fleet_job(void *context, int index)
+{
+  struct fleet *f = context;
+  struct cruise_vehicle vehicle;
+  struct cruise_controller control;
+  struct input_snapshot in;
+  unsigned long long state = f->seed ^ ((unsigned long long) index << 32);
+  INT32U ms, release, brake;
+  INT8U throttle = 0;
+
+  sim_random(&state);
+  cruise_vehicle_init(&vehicle);
+  cruise_controller_init(&control);
+  cruise_vehicle_set(&vehicle, sim_random(&state) % track_length, 0);
+  release = 15000 + sim_random(&state) % 25000;
+  brake   = release + 30000 + sim_random(&state) % 60000;
+
+  for (ms = VEHICLE_PERIOD; ms <= f->duration_ms; ms += VEHICLE_PERIOD) {
+    cruise_vehicle_step(&vehicle, throttle, control.brake_pedal,
+                        VEHICLE_PERIOD);
+    if (ms % CONTROL_PERIOD != 0)
+      continue;
+    fleet_inputs(&in, ms, release, brake);
+    throttle = cruise_controller_step(&control, &in, vehicle.plant.position,
+                                      vehicle.plant.velocity);
+    if (control.cruise_control == on)
+      f->v[index].target = control.target_vel;
+  }
+  f->v[index].velocity = vehicle.plant.velocity;
+  f->v[index].position = vehicle.plant.position;
+}
+
+static double fleet_now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+  struct fleet f;
+  unsigned long long digest = 1469598103934665603ULL;
+  int vehicles = 10000, threads = sim_cores(), seconds = 120, i, opt;
+  INT32U cruising = 0;
+  double t0, t;
+
+  f.seed = 1;
+  while ((opt = getopt(argc, argv, "n:j:t:s:")) != -1) {
+    switch (opt) {
+    case 'n': vehicles = atoi(optarg); break;
+    case 'j': threads = atoi(optarg); break;
+    case 't': seconds = atoi(optarg); break;
+    case 's': f.seed = strtoull(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-n vehicles] [-j threads] [-t seconds] "
+              "[-s seed]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (vehicles < 1 || threads < 1 || seconds < 1) {
+    fprintf(stderr, "%s: at least 1 vehicle, 1 thread and 1 s\n", argv[0]);
+    return 1;
+  }
+  f.duration_ms = (INT32U) seconds * 1000;
+  f.v = calloc(vehicles, sizeof(*f.v));
+  if (f.v == NULL) {
+    perror("calloc");
+    return 1;
+  }
+
+  t0 = fleet_now();
+  sim_parallel(vehicles, threads, fleet_job, &f);
+  t = fleet_now() - t0;
+
+  for (i = 0; i < vehicles; i++) {
+    digest = (digest ^ f.v[i].target ^ (unsigned long long) f.v[i].position
+              << 16 ^ (unsigned long long) (INT16U) f.v[i].velocity << 48) *
+             1099511628211ULL;
+    cruising += f.v[i].target != 0;
+  }
+  printf("%d vehicles, %d s each, %d threads: %.2f s, %.0f vehicle steps "
+         "per second\n", vehicles, seconds, threads, t,
+         (double) vehicles * (f.duration_ms / VEHICLE_PERIOD) / t);
+  printf("%lu engaged the cruise control\n", (unsigned long) cruising);
+  printf("digest %016llx\n", digest);
+  free(f.v);
+  return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * Host (Linux) stand-in for the 'includes.h' of the Nios II uC/OS-II BSP.
+ */
+#ifndef __INCLUDES_H__
+#define __INCLUDES_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alt_types.h"
+#include "ucos_ii.h"
+
+#endif /* __INCLUDES_H__ */
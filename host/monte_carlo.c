@@ -0,0 +1,288 @@
+/*
+ * Monte Carlo robustness campaign of the cruise control (host only)
+ *
+ * Each run draws a scenario from its own random stream, seeded by the
+ * campaign seed and the number of the run:
+ *
+ *   drag        wind_div MC_WIND_DIV_MIN..MAX (10000 on the board), rolling
+ *               resistance 0..MC_ROLLING_MAX
+ *   terrain     a slope of MC_SLOPE_MIN..MAX for each segment of the track
+ *               of TRACK_TABLE
+ *   start       position on the track and velocity 0..MC_VELOCITY_MAX
+ *   set-point   the driver works the gas pedal towards 20..MC_DRIVER_MAX
+ *               m/s and engages the cruise control after MC_ENGAGE_MIN..MAX
+ *               ms, at the velocity reached then (sim.h)
+ *
+ * and drives one lap with the cruise control of ControlTask (sim.c).  The
+ * runs are spread over a pool of threads; a run depends on nothing but its
+ * number, so the results are the same for any number of threads and the
+ * time scales with the cores.  The report gives, over the engaged runs,
+ * the distribution of the worst speed error of a run and the time the
+ * throttle spent at its limit, with the numbers of the worst runs; -i
+ * prints the scenario and result of one run.
+ *
+ *   monte_carlo [-n runs] [-s seed] [-j threads] [-k kp,ki,kd] [-i run]
+ *               [-S]
+ *
+ * -S runs the campaign with 1, 2, 4 ... threads up to -j and reports the
+ * speed-up.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define MC_WIND_DIV_MIN  7000
+#define MC_WIND_DIV_MAX  14000
+#define MC_ROLLING_MAX   2
+#define MC_SLOPE_MIN     (-10)
+#define MC_SLOPE_MAX     25
+#define MC_VELOCITY_MAX  400    /* 0.1 m/s */
+#define MC_DRIVER_MAX    350    /* 0.1 m/s */
+#define MC_ENGAGE_MIN    5000   /* ms */
+#define MC_ENGAGE_MAX    60000
+#define MC_SEGMENTS_MAX  1024
+#define MC_ERROR_MAX     1024   /* Histogram of the worst errors, 0.1 m/s */
+
+struct mc_run {
+  INT16U max_error;             /* 0.1 m/s */
+  INT8U  engaged;
+  INT8U  finished;
+  INT16U dropouts;              /* The cruise control went off */
+  INT32U saturated_ms;
+  INT32U engaged_ms;            /* Time driven with the cruise control */
+};
+
+struct mc_campaign {
+  unsigned long long seed;
+  struct sim_gains   gains;
+  struct mc_run     *run;
+};
+
+static long mc_uniform(unsigned long long *state, long min, long max)
+{
+  return min + (long) (sim_random(state) %
+                       (unsigned long long) (max - min + 1));
+}
+
+static void mc_scenario(unsigned long long seed, int index,
+                        struct sim_scenario *s, INT8S *slope)
+{
+  unsigned long long state = seed ^ ((unsigned long long) index << 32);
+  INT16U i;
+
+  sim_random(&state);
+  memset(s, 0, sizeof(*s));
+  s->drag.wind_div = mc_uniform(&state, MC_WIND_DIV_MIN, MC_WIND_DIV_MAX);
+  s->drag.rolling  = mc_uniform(&state, 0, MC_ROLLING_MAX);
+  for (i = 0; i < track_segments; i++)
+    slope[i] = mc_uniform(&state, MC_SLOPE_MIN, MC_SLOPE_MAX);
+  s->slope           = slope;
+  s->start           = mc_uniform(&state, 0, track_length - 1);
+  s->velocity        = mc_uniform(&state, 0, MC_VELOCITY_MAX);
+  s->driver_velocity = mc_uniform(&state, SIM_ENGAGE_MIN, MC_DRIVER_MAX);
+  s->engage_ms       = mc_uniform(&state, MC_ENGAGE_MIN, MC_ENGAGE_MAX);
+  s->distance        = track_length;
+  /* A lap at 10 m/s after the latest engagement */
+  s->max_ms          = MC_ENGAGE_MAX + track_length * 10;
+}
+
+static void mc_job(void *context, int index)
+{
+  struct mc_campaign *c = context;
+  struct sim_scenario s;
+  struct sim_result r;
+  struct mc_run *run = &c->run[index];
+  INT8S slope[MC_SEGMENTS_MAX];
+
+  mc_scenario(c->seed, index, &s, slope);
+  sim_run(&c->gains, &s, &r);
+  run->engaged      = r.engaged;
+  run->finished     = r.finished;
+  run->dropouts     = r.dropouts < 0xffff ? r.dropouts : 0xffff;
+  run->max_error    = r.max_error < 0xffff ? r.max_error : 0xffff;
+  run->saturated_ms = r.saturated_ms;
+  run->engaged_ms   = r.control_steps * CONTROL_PERIOD;
+}
+
+static double mc_now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static double mc_campaign_run(struct mc_campaign *c, int runs, int threads)
+{
+  double t0 = mc_now();
+
+  sim_parallel(runs, threads, mc_job, c);
+  return mc_now() - t0;
+}
+
+/* Smallest error that 'fraction' of the engaged runs do not exceed */
+static double mc_percentile(const INT32U *hist, INT32U total, double fraction)
+{
+  INT32U sum = 0, need = (INT32U) (fraction * total + 0.5);
+  int e;
+
+  for (e = 0; e < MC_ERROR_MAX; e++) {
+    sum += hist[e];
+    if (sum >= need && sum > 0)
+      return e / 10.0;
+  }
+  return MC_ERROR_MAX / 10.0;
+}
+
+static void mc_print_run(struct mc_campaign *c, int index)
+{
+  struct sim_scenario s;
+  struct sim_result r;
+  INT8S slope[MC_SEGMENTS_MAX];
+  INT16U i;
+
+  mc_scenario(c->seed, index, &s, slope);
+  sim_run(&c->gains, &s, &r);
+  printf("Run %d of seed %llu\n", index, c->seed);
+  printf("  drag        wind_div %u, rolling %d\n", s.drag.wind_div,
+         s.drag.rolling);
+  printf("  slopes     ");
+  for (i = 0; i < track_segments; i++)
+    printf(" %d", slope[i]);
+  printf("\n  start       %lu.%lu m at %d.%d m/s\n",
+         (unsigned long) s.start / 10, (unsigned long) s.start % 10,
+         s.velocity / 10, s.velocity % 10);
+  printf("  driver      %d.%d m/s, engages after %lu ms\n",
+         s.driver_velocity / 10, s.driver_velocity % 10,
+         (unsigned long) s.engage_ms);
+  if (!r.engaged) {
+    printf("  not engaged in %lu ms\n", (unsigned long) s.max_ms);
+    return;
+  }
+  printf("  engaged     at %lu ms, %d.%d m/s\n", (unsigned long) r.engage_ms,
+         r.target / 10, r.target % 10);
+  printf("  worst error %lu.%lu m/s, %lu ms at full throttle, lap %s\n",
+         (unsigned long) r.max_error / 10, (unsigned long) r.max_error % 10,
+         (unsigned long) r.saturated_ms,
+         r.finished ? "driven" : "not driven");
+  if (r.dropouts > 0)
+    printf("  dropouts    %lu, the cruise control went off below 20 m/s\n",
+           (unsigned long) r.dropouts);
+}
+
+int main(int argc, char *argv[])
+{
+  struct mc_campaign c;
+  static INT32U hist[MC_ERROR_MAX];
+  struct sim_gains k = SIM_GAINS;
+  double t, t1 = 0;
+  unsigned long long saturated = 0, engaged_ms = 0, digest = 1469598103934665603ULL;
+  INT32U engaged = 0, unfinished = 0, dropped = 0, any_saturated = 0;
+  int runs = 20000, threads = sim_cores(), one = -1, scaling = 0;
+  int i, opt, worst = -1, worst_sat = -1;
+
+  c.seed = 1;
+  while ((opt = getopt(argc, argv, "n:s:j:k:i:S")) != -1) {
+    switch (opt) {
+    case 'n': runs = atoi(optarg); break;
+    case 's': c.seed = strtoull(optarg, NULL, 0); break;
+    case 'j': threads = atoi(optarg); break;
+    case 'k':
+      if (sscanf(optarg, "%lf,%lf,%lf", &k.kp, &k.ki, &k.kd) != 3) {
+        fprintf(stderr, "%s: -k kp,ki,kd\n", argv[0]);
+        return 1;
+      }
+      break;
+    case 'i': one = atoi(optarg); break;
+    case 'S': scaling = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-n runs] [-s seed] [-j threads] "
+              "[-k kp,ki,kd] [-i run] [-S]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (track_segments > MC_SEGMENTS_MAX) {
+    fprintf(stderr, "%s: more than %d track segments\n", argv[0],
+            MC_SEGMENTS_MAX);
+    return 1;
+  }
+  if (runs < 1 || threads < 1) {
+    fprintf(stderr, "%s: at least 1 run and 1 thread\n", argv[0]);
+    return 1;
+  }
+  c.gains = k;
+  if (one >= 0) {
+    mc_print_run(&c, one);
+    return 0;
+  }
+  c.run = malloc(runs * sizeof(*c.run));
+  if (c.run == NULL) {
+    perror("malloc");
+    return 1;
+  }
+
+  printf("%d runs of seed %llu, Kp %g Ki %g Kd %g, track of %lu.%lu km\n",
+         runs, c.seed, k.kp, k.ki, k.kd, (unsigned long) track_length / 10000,
+         (unsigned long) track_length / 1000 % 10);
+  if (scaling) {
+    printf("\nthreads   time_s   runs/s  speed-up\n");
+    for (i = 1; i <= threads; i = i < threads && i * 2 > threads ?
+                                    threads : i * 2) {
+      t = mc_campaign_run(&c, runs, i);
+      if (i == 1)
+        t1 = t;
+      printf("%7d %8.2f %8.0f %9.2f\n", i, t, runs / t, t1 / t);
+    }
+    printf("\n");
+  } else {
+    t = mc_campaign_run(&c, runs, threads);
+    printf("%d threads: %.2f s, %.0f runs per second\n\n", threads, t,
+           runs / t);
+  }
+
+  /* Aggregated in the order of the runs */
+  for (i = 0; i < runs; i++) {
+    struct mc_run *r = &c.run[i];
+
+    digest = (digest ^ r->max_error ^ (unsigned long long) r->saturated_ms
+              << 16 ^ (unsigned long long) r->engaged << 48) *
+             1099511628211ULL;
+    if (!r->engaged)
+      continue;
+    engaged++;
+    unfinished += !r->finished;
+    dropped    += r->dropouts > 0;
+    hist[r->max_error < MC_ERROR_MAX ? r->max_error : MC_ERROR_MAX - 1]++;
+    if (worst < 0 || r->max_error > c.run[worst].max_error)
+      worst = i;
+    if (r->saturated_ms > 0)
+      any_saturated++;
+    if (worst_sat < 0 || r->saturated_ms > c.run[worst_sat].saturated_ms)
+      worst_sat = i;
+    saturated  += r->saturated_ms;
+    engaged_ms += r->engaged_ms;
+  }
+
+  printf("engaged              %lu of %d runs, %lu did not drive the lap, "
+         "%lu dropped out\n", (unsigned long) engaged, runs,
+         (unsigned long) unfinished, (unsigned long) dropped);
+  if (engaged == 0)
+    return 0;
+  printf("worst speed error    p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  "
+         "max %.1f m/s (run %d)\n", mc_percentile(hist, engaged, 0.5),
+         mc_percentile(hist, engaged, 0.9), mc_percentile(hist, engaged, 0.99),
+         mc_percentile(hist, engaged, 0.999), c.run[worst].max_error / 10.0,
+         worst);
+  printf("full throttle        %.2f %% of the time, in %.1f %% of the runs, "
+         "max %.1f s (run %d)\n",
+         engaged_ms ? 100.0 * saturated / engaged_ms : 0,
+         100.0 * any_saturated / engaged,
+         c.run[worst_sat].saturated_ms / 1000.0, worst_sat);
+  printf("digest               %016llx\n", digest);
+  free(c.run);
+  return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * uC/OS-II configuration for the host (Linux) build.
+ *
+ * Mirrors the settings of the Nios II BSP used on the DE2 board.
+ */
+#ifndef __OS_CFG_H__
+#define __OS_CFG_H__
+
+#define OS_LOWEST_PRIO          20   /* Idle task, statistic task one above */
+#define OS_MAX_TASKS            16
+#define OS_MAX_EVENTS           60
+#define OS_MAX_FLAGS            20
+
+#define OS_TICKS_PER_SEC      1000   /* Same as alt_ticks_per_second() */
+
+#define OS_APP_HOOKS_EN          1   /* App_*Hook(), see app_hooks.c */
+
+#define OS_TMR_CFG_MAX          16
+#define OS_TASK_TMR_PRIO         0
+
+/*
+ * Host thread stacks are OS_HOST_STK_SCALE times the requested size: the
+ * C library of the host needs far more stack than newlib on the Nios II.
+ */
+#define OS_HOST_STK_SCALE       16
+
+#endif /* __OS_CFG_H__ */
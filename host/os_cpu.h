@@ -0,0 +1,50 @@
+/*
+ * uC/OS-II processor port header for the host (Linux) build.
+ *
+ * The data types match the Nios II port so the application sees the same
+ * sizes as on the DE2 board.  "Disabling interrupts" takes the kernel lock
+ * of the host port (see os_host.c).
+ */
+#ifndef __OS_CPU_H__
+#define __OS_CPU_H__
+
+typedef unsigned char  BOOLEAN;
+typedef unsigned char  INT8U;
+typedef signed   char  INT8S;
+typedef unsigned short INT16U;
+typedef signed   short INT16S;
+typedef unsigned int   INT32U;
+typedef signed   int   INT32S;
+typedef float          FP32;
+typedef double         FP64;
+
+typedef INT32U         OS_STK;    /* Each stack entry is 32-bit wide */
+typedef INT32U         OS_CPU_SR; /* Unused on the host, kept for the API */
+
+#define OS_CRITICAL_METHOD 3
+#define OS_STK_GROWTH      1      /* Stack grows from HIGH to LOW memory */
+
+#define OS_ENTER_CRITICAL() do { (void) cpu_sr; os_host_lock(); } while (0)
+#define OS_EXIT_CRITICAL()  do { os_host_unlock(); } while (0)
+
+/*
+ * Host port services used by the stand-in HAL (alt_host.c)
+ */
+void  os_host_lock(void);
+void  os_host_unlock(void);
+void  os_host_stop(void);
+void  os_host_set_virtual(void);
+
+/*
+ * System clock of the stand-in HAL, driven by the idle task of the port
+ * in virtual time mode
+ */
+INT32U alt_host_clock_ticks(void);
+INT32U alt_host_clock_ticks_to_event(void);
+void   alt_host_clock_skip(INT32U ticks);
+void   alt_host_clock_tick(void);
+
+/* Called by the idle task whenever every task is blocked */
+void   alt_host_idle(void);
+
+#endif /* __OS_CPU_H__ */
@@ -0,0 +1,1305 @@
+/*
+ * uC/OS-II API port for the host (Linux) build.
+ *
+ * Every task runs on its own pthread, but only the task the scheduler has
+ * made current (OSTCBCur) may execute; all other task threads wait on
+ * their condition variable until they are dispatched.  This keeps the
+ * single-CPU, fixed-priority semantics of uC/OS-II, so the application
+ * tasks run unmodified.  The kernel lock stands in for disabling
+ * interrupts on the target.
+ *
+ * The thread that calls OSStart() becomes the idle task.  Interrupts come
+ * from the system clock thread of alt_host.c (OSIntEnter()/OSIntExit()).
+ * A task made ready by an ISR is dispatched at once if the CPU is idle;
+ * otherwise the running task is preempted at its next kernel call, i.e.
+ * code between two kernel calls is never interleaved with another task.
+ *
+ * In virtual time mode (os_host_set_virtual()) all tasks are coroutines
+ * on the thread that calls OSStart() and there is no clock thread: time
+ * stands still while a task runs, and whenever every task is blocked the
+ * idle task advances the clock straight to the next pending event - the
+ * earliest task delay or pend timeout here, or alarm, input change or end
+ * of run in alt_host.c - and raises the tick interrupt for it.  Runs are
+ * deterministic and only cost the CPU time the tasks actually use.
+ */
+#include <pthread.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <limits.h>
+
+#include "includes.h"
+
+#define OS_N_SYS_TASKS 3             /* Idle, statistic and timer task   */
+
+typedef struct os_host_task {
+  pthread_t       thread;
+  pthread_cond_t  run;               /* Signalled when dispatched         */
+  ucontext_t      ctx;               /* Coroutine in virtual time mode    */
+  void          (*task)(void *p_arg);
+  void           *p_arg;
+  INT32U         *stk;               /* Host stack, see OSTaskStkChk()    */
+  size_t          stk_bytes;
+} OS_HOST_TASK;
+
+/*
+ * Global variables
+ */
+INT8U   OSCPUUsage;
+INT32U  OSIdleCtr;
+INT32U  OSIdleCtrMax;
+INT32U  OSCtxSwCtr;
+INT8U   OSIntNesting;
+INT8U   OSLockNesting;
+BOOLEAN OSRunning;
+INT32U  OSTime;
+INT32U  OSTmrTime;
+OS_TCB *OSTCBCur;
+OS_TCB *OSTCBHighRdy;
+OS_TCB *OSTCBPrioTbl[OS_LOWEST_PRIO + 1];
+
+static OS_TCB       OSTCBTbl[OS_MAX_TASKS + OS_N_SYS_TASKS];
+static OS_HOST_TASK OSHostTbl[OS_MAX_TASKS + OS_N_SYS_TASKS];
+static INT16U       OSTCBUsed;
+
+static OS_EVENT     OSEventTbl[OS_MAX_EVENTS];
+static OS_FLAG_GRP  OSFlagTbl[OS_MAX_FLAGS];
+static OS_TMR       OSTmrTbl[OS_TMR_CFG_MAX];
+
+static OS_TCB      *OSTCBIdle;
+static OS_EVENT    *OSTmrSemSignal;
+static BOOLEAN      OSStatRdy;
+
+static OS_STK       OSTaskStatStk[1024];
+static OS_STK       OSTaskTmrStk[1024];
+
+/*
+ * Host state
+ */
+static pthread_mutex_t os_mutex;
+static __thread int    os_lock_depth;
+static __thread OS_TCB *os_self;     /* Task backed by the calling thread */
+static BOOLEAN         os_initialized;
+static BOOLEAN         os_stopping;
+static BOOLEAN         os_virtual;
+
+static long long       os_idle_ns;   /* Total time spent in the idle task */
+static long long       os_idle_since;
+
+#define OS_HOST(ptcb) ((OS_HOST_TASK *) (ptcb)->OSTCBHost)
+
+#if OS_APP_HOOKS_EN > 0
+/* Weak, so that the benchmarks link without app_hooks.o */
+extern void App_TaskSwHook(void)   __attribute__((weak));
+extern void App_TimeTickHook(void) __attribute__((weak));
+extern void App_TaskIdleHook(void) __attribute__((weak));
+#endif
+
+static long long os_host_now_ns(void)
+{
+  struct timespec ts;
+
+  if (os_virtual)
+    return (long long) alt_host_clock_ticks() * (1000000000LL / OS_TICKS_PER_SEC);
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Scheduler
+ */
+static OS_TCB *OS_SchedNew(void)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+
+  for (prio = 0; prio <= OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb != NULL && ptcb->OSTCBStat == OS_STAT_RDY && ptcb->OSTCBDly == 0)
+      return ptcb;
+  }
+  return OSTCBIdle;
+}
+
+/* Makes 'pnext' the running task and wakes its thread */
+static void OS_SetCur(OS_TCB *pnext)
+{
+  long long now = os_host_now_ns();
+
+  if (OSTCBCur == OSTCBIdle)
+    os_idle_ns += now - os_idle_since;
+  if (pnext == OSTCBIdle)
+    os_idle_since = now;
+
+  OSTCBHighRdy = pnext;
+#if OS_APP_HOOKS_EN > 0
+  if (App_TaskSwHook != NULL)
+    App_TaskSwHook();
+#endif
+  OSTCBCur = pnext;
+  pnext->OSTCBCtxSwCtr++;
+  OSCtxSwCtr++;
+  if (!os_virtual)
+    pthread_cond_signal(&OS_HOST(pnext)->run);
+}
+
+/* Waits (kernel lock held once) until 'ptcb' is dispatched */
+static void OS_WaitDispatch(OS_TCB *ptcb)
+{
+  while (OSTCBCur != ptcb)
+    pthread_cond_wait(&OS_HOST(ptcb)->run, &os_mutex);
+}
+
+/*
+ * Switches from the running task to 'pnext' and returns once the calling
+ * task is dispatched again.  The lock depth belongs to the task, so a
+ * coroutine keeps its own across the switch.
+ */
+static void OS_CtxSw(OS_TCB *pnext)
+{
+  OS_TCB *pself = OSTCBCur;
+  int depth = os_lock_depth;
+
+  OS_SetCur(pnext);
+  if (os_virtual)
+    swapcontext(&OS_HOST(pself)->ctx, &OS_HOST(pnext)->ctx);
+  else
+    OS_WaitDispatch(pself);
+  os_lock_depth = depth;
+  os_self = pself;
+}
+
+/* Only tasks reschedule here; the idle task dispatches in OSStart() */
+static void OS_Sched(void)
+{
+  OS_TCB *pnext;
+
+  if (OSIntNesting > 0 || OSLockNesting > 0 || OSRunning == FALSE)
+    return;
+  if (os_self != OSTCBCur || OSTCBCur == OSTCBIdle)
+    return;
+  pnext = OS_SchedNew();
+  if (pnext != OSTCBCur)
+    OS_CtxSw(pnext);
+}
+
+void os_host_lock(void)
+{
+  if (!os_virtual)
+    pthread_mutex_lock(&os_mutex);
+  os_lock_depth++;
+}
+
+/*
+ * Leaving the outermost critical section is a preemption point: a task
+ * made ready by an ISR meanwhile takes over the CPU here.
+ */
+void os_host_unlock(void)
+{
+  if (os_lock_depth == 1)
+    OS_Sched();
+  os_lock_depth--;
+  if (!os_virtual)
+    pthread_mutex_unlock(&os_mutex);
+}
+
+/* Selects virtual time mode; must precede OSInit() */
+void os_host_set_virtual(void)
+{
+  os_virtual = TRUE;
+}
+
+/*
+ * Requests the end of the run: the idle task exits the process the next
+ * time the CPU is idle, so no task is stopped halfway through a cycle.
+ */
+void os_host_stop(void)
+{
+  os_host_lock();
+  os_stopping = TRUE;
+  if (OSTCBIdle != NULL && !os_virtual)
+    pthread_cond_signal(&OS_HOST(OSTCBIdle)->run);
+  os_host_unlock();
+}
+
+/*
+ * Events
+ */
+static void OS_EventTaskWait(void *pevent, INT8U stat, INT16U timeout)
+{
+  OSTCBCur->OSTCBStat     |= stat;
+  OSTCBCur->OSTCBPendTO    = FALSE;
+  OSTCBCur->OSTCBEventPtr  = pevent;
+  OSTCBCur->OSTCBDly       = timeout;
+  OS_Sched();
+  OSTCBCur->OSTCBEventPtr  = NULL;
+}
+
+/* Readies the highest priority task waiting on 'pevent' */
+static OS_TCB *OS_EventTaskRdy(void *pevent, void *pmsg, INT8U msk)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+
+  for (prio = 0; prio < OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb != NULL && ptcb->OSTCBEventPtr == pevent &&
+        (ptcb->OSTCBStat & msk) != 0) {
+      ptcb->OSTCBDly       = 0;
+      ptcb->OSTCBEventPtr  = NULL;
+      ptcb->OSTCBMsg       = pmsg;
+      ptcb->OSTCBStat     &= ~msk;
+      ptcb->OSTCBPendTO    = FALSE;
+      return ptcb;
+    }
+  }
+  return NULL;
+}
+
+static OS_EVENT *OS_EventAlloc(INT8U type)
+{
+  INT16U i;
+
+  for (i = 0; i < OS_MAX_EVENTS; i++) {
+    if (OSEventTbl[i].OSEventType == OS_EVENT_TYPE_UNUSED) {
+      OSEventTbl[i].OSEventType = type;
+      OSEventTbl[i].OSEventPtr  = NULL;
+      OSEventTbl[i].OSEventCnt  = 0;
+      return &OSEventTbl[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Semaphores
+ */
+OS_EVENT *OSSemCreate(INT16U cnt)
+{
+  OS_EVENT *pevent;
+
+  if (OSIntNesting > 0)
+    return NULL;
+  os_host_lock();
+  pevent = OS_EventAlloc(OS_EVENT_TYPE_SEM);
+  if (pevent != NULL)
+    pevent->OSEventCnt = cnt;
+  os_host_unlock();
+  return pevent;
+}
+
+void OSSemPend(OS_EVENT *pevent, INT16U timeout, INT8U *perr)
+{
+  if (pevent == NULL) {
+    *perr = OS_ERR_PEVENT_NULL;
+    return;
+  }
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_PEND_ISR;
+    return;
+  }
+  if (OSLockNesting > 0) {
+    *perr = OS_ERR_PEND_LOCKED;
+    return;
+  }
+  os_host_lock();
+  if (pevent->OSEventCnt > 0) {
+    pevent->OSEventCnt--;
+    *perr = OS_ERR_NONE;
+  } else {
+    OS_EventTaskWait(pevent, OS_STAT_SEM, timeout);
+    *perr = OSTCBCur->OSTCBPendTO ? OS_ERR_TIMEOUT : OS_ERR_NONE;
+  }
+  os_host_unlock();
+}
+
+INT8U OSSemPost(OS_EVENT *pevent)
+{
+  INT8U err = OS_ERR_NONE;
+
+  if (pevent == NULL)
+    return OS_ERR_PEVENT_NULL;
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM)
+    return OS_ERR_EVENT_TYPE;
+  os_host_lock();
+  if (OS_EventTaskRdy(pevent, NULL, OS_STAT_SEM) != NULL)
+    OS_Sched();
+  else if (pevent->OSEventCnt < 65535U)
+    pevent->OSEventCnt++;
+  else
+    err = OS_ERR_SEM_OVF;
+  os_host_unlock();
+  return err;
+}
+
+INT16U OSSemAccept(OS_EVENT *pevent)
+{
+  INT16U cnt;
+
+  if (pevent == NULL || pevent->OSEventType != OS_EVENT_TYPE_SEM)
+    return 0;
+  os_host_lock();
+  cnt = pevent->OSEventCnt;
+  if (cnt > 0)
+    pevent->OSEventCnt--;
+  os_host_unlock();
+  return cnt;
+}
+
+/*
+ * Mailboxes
+ */
+OS_EVENT *OSMboxCreate(void *pmsg)
+{
+  OS_EVENT *pevent;
+
+  if (OSIntNesting > 0)
+    return NULL;
+  os_host_lock();
+  pevent = OS_EventAlloc(OS_EVENT_TYPE_MBOX);
+  if (pevent != NULL)
+    pevent->OSEventPtr = pmsg;
+  os_host_unlock();
+  return pevent;
+}
+
+void *OSMboxPend(OS_EVENT *pevent, INT16U timeout, INT8U *perr)
+{
+  void *pmsg;
+
+  if (pevent == NULL) {
+    *perr = OS_ERR_PEVENT_NULL;
+    return NULL;
+  }
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return NULL;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_PEND_ISR;
+    return NULL;
+  }
+  if (OSLockNesting > 0) {
+    *perr = OS_ERR_PEND_LOCKED;
+    return NULL;
+  }
+  os_host_lock();
+  pmsg = pevent->OSEventPtr;
+  if (pmsg != NULL) {
+    pevent->OSEventPtr = NULL;
+    *perr = OS_ERR_NONE;
+  } else {
+    OSTCBCur->OSTCBMsg = NULL;
+    OS_EventTaskWait(pevent, OS_STAT_MBOX, timeout);
+    if (OSTCBCur->OSTCBPendTO) {
+      *perr = OS_ERR_TIMEOUT;
+    } else {
+      pmsg = OSTCBCur->OSTCBMsg;
+      *perr = OS_ERR_NONE;
+    }
+  }
+  os_host_unlock();
+  return pmsg;
+}
+
+INT8U OSMboxPost(OS_EVENT *pevent, void *pmsg)
+{
+  INT8U err = OS_ERR_NONE;
+
+  if (pevent == NULL)
+    return OS_ERR_PEVENT_NULL;
+  if (pmsg == NULL)
+    return OS_ERR_POST_NULL_PTR;
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX)
+    return OS_ERR_EVENT_TYPE;
+  os_host_lock();
+  if (OS_EventTaskRdy(pevent, pmsg, OS_STAT_MBOX) != NULL)
+    OS_Sched();
+  else if (pevent->OSEventPtr != NULL)
+    err = OS_ERR_MBOX_FULL;
+  else
+    pevent->OSEventPtr = pmsg;
+  os_host_unlock();
+  return err;
+}
+
+void *OSMboxAccept(OS_EVENT *pevent)
+{
+  void *pmsg;
+
+  if (pevent == NULL || pevent->OSEventType != OS_EVENT_TYPE_MBOX)
+    return NULL;
+  os_host_lock();
+  pmsg = pevent->OSEventPtr;
+  pevent->OSEventPtr = NULL;
+  os_host_unlock();
+  return pmsg;
+}
+
+/*
+ * Event flags
+ */
+
+/* Returns the flags of 'flags' satisfying 'wait_type', 0 if not all are */
+static OS_FLAGS OS_FlagTest(OS_FLAG_GRP *pgrp, OS_FLAGS flags,
+                            INT8U wait_type)
+{
+  OS_FLAGS rdy;
+
+  switch (wait_type & ~OS_FLAG_CONSUME) {
+  case OS_FLAG_WAIT_SET_ALL:
+    rdy = pgrp->OSFlagFlags & flags;
+    return rdy == flags ? rdy : 0;
+  case OS_FLAG_WAIT_SET_ANY:
+    return pgrp->OSFlagFlags & flags;
+  case OS_FLAG_WAIT_CLR_ALL:
+    rdy = ~pgrp->OSFlagFlags & flags;
+    return rdy == flags ? rdy : 0;
+  case OS_FLAG_WAIT_CLR_ANY:
+    return ~pgrp->OSFlagFlags & flags;
+  }
+  return 0;
+}
+
+static void OS_FlagConsume(OS_FLAG_GRP *pgrp, OS_FLAGS rdy, INT8U wait_type)
+{
+  if ((wait_type & OS_FLAG_CONSUME) == 0)
+    return;
+  if ((wait_type & ~OS_FLAG_CONSUME) >= OS_FLAG_WAIT_SET_ALL)
+    pgrp->OSFlagFlags &= ~rdy;
+  else
+    pgrp->OSFlagFlags |= rdy;
+}
+
+OS_FLAG_GRP *OSFlagCreate(OS_FLAGS flags, INT8U *perr)
+{
+  INT16U i;
+  OS_FLAG_GRP *pgrp = NULL;
+
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_CREATE_ISR;
+    return NULL;
+  }
+  os_host_lock();
+  for (i = 0; i < OS_MAX_FLAGS; i++) {
+    if (OSFlagTbl[i].OSFlagType == OS_EVENT_TYPE_UNUSED) {
+      pgrp = &OSFlagTbl[i];
+      pgrp->OSFlagType  = OS_EVENT_TYPE_FLAG;
+      pgrp->OSFlagFlags = flags;
+      break;
+    }
+  }
+  os_host_unlock();
+  *perr = pgrp != NULL ? OS_ERR_NONE : OS_ERR_FLAG_GRP_DEPLETED;
+  return pgrp;
+}
+
+OS_FLAGS OSFlagPend(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U wait_type,
+                    INT16U timeout, INT8U *perr)
+{
+  OS_FLAGS rdy;
+
+  if (pgrp == NULL) {
+    *perr = OS_ERR_FLAG_INVALID_PGRP;
+    return 0;
+  }
+  if (pgrp->OSFlagType != OS_EVENT_TYPE_FLAG) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return 0;
+  }
+  if ((wait_type & ~OS_FLAG_CONSUME) > OS_FLAG_WAIT_SET_ANY) {
+    *perr = OS_ERR_FLAG_WAIT_TYPE;
+    return 0;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_PEND_ISR;
+    return 0;
+  }
+  if (OSLockNesting > 0) {
+    *perr = OS_ERR_PEND_LOCKED;
+    return 0;
+  }
+  os_host_lock();
+  rdy = OS_FlagTest(pgrp, flags, wait_type);
+  if (rdy != 0) {
+    OS_FlagConsume(pgrp, rdy, wait_type);
+    *perr = OS_ERR_NONE;
+  } else {
+    OSTCBCur->OSTCBFlagsWait    = flags;
+    OSTCBCur->OSTCBFlagWaitType = wait_type;
+    OSTCBCur->OSTCBFlagsRdy     = 0;
+    OS_EventTaskWait(pgrp, OS_STAT_FLAG, timeout);
+    if (OSTCBCur->OSTCBPendTO) {
+      *perr = OS_ERR_TIMEOUT;
+    } else {
+      rdy = OSTCBCur->OSTCBFlagsRdy;
+      OS_FlagConsume(pgrp, rdy, wait_type);
+      *perr = OS_ERR_NONE;
+    }
+  }
+  os_host_unlock();
+  return rdy;
+}
+
+OS_FLAGS OSFlagPost(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U opt,
+                    INT8U *perr)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+  OS_FLAGS rdy, cur;
+  BOOLEAN sched = FALSE;
+
+  if (pgrp == NULL) {
+    *perr = OS_ERR_FLAG_INVALID_PGRP;
+    return 0;
+  }
+  if (pgrp->OSFlagType != OS_EVENT_TYPE_FLAG) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return 0;
+  }
+  os_host_lock();
+  switch (opt) {
+  case OS_FLAG_CLR:
+    pgrp->OSFlagFlags &= ~flags;
+    break;
+  case OS_FLAG_SET:
+    pgrp->OSFlagFlags |= flags;
+    break;
+  default:
+    os_host_unlock();
+    *perr = OS_ERR_FLAG_INVALID_OPT;
+    return 0;
+  }
+  for (prio = 0; prio < OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb == NULL || ptcb->OSTCBEventPtr != pgrp ||
+        (ptcb->OSTCBStat & OS_STAT_FLAG) == 0)
+      continue;
+    rdy = OS_FlagTest(pgrp, ptcb->OSTCBFlagsWait, ptcb->OSTCBFlagWaitType);
+    if (rdy != 0) {
+      OS_EventTaskRdy(pgrp, NULL, OS_STAT_FLAG);
+      ptcb->OSTCBFlagsRdy = rdy;
+      sched = TRUE;
+    }
+  }
+  if (sched)
+    OS_Sched();
+  cur = pgrp->OSFlagFlags;
+  os_host_unlock();
+  *perr = OS_ERR_NONE;
+  return cur;
+}
+
+OS_FLAGS OSFlagAccept(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U wait_type,
+                      INT8U *perr)
+{
+  OS_FLAGS rdy;
+
+  if (pgrp == NULL) {
+    *perr = OS_ERR_FLAG_INVALID_PGRP;
+    return 0;
+  }
+  if (pgrp->OSFlagType != OS_EVENT_TYPE_FLAG) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return 0;
+  }
+  if ((wait_type & ~OS_FLAG_CONSUME) > OS_FLAG_WAIT_SET_ANY) {
+    *perr = OS_ERR_FLAG_WAIT_TYPE;
+    return 0;
+  }
+  os_host_lock();
+  rdy = OS_FlagTest(pgrp, flags, wait_type);
+  if (rdy != 0) {
+    OS_FlagConsume(pgrp, rdy, wait_type);
+    *perr = OS_ERR_NONE;
+  } else {
+    *perr = OS_ERR_FLAG_NOT_RDY;
+  }
+  os_host_unlock();
+  return rdy;
+}
+
+OS_FLAGS OSFlagQuery(OS_FLAG_GRP *pgrp, INT8U *perr)
+{
+  OS_FLAGS flags;
+
+  if (pgrp == NULL) {
+    *perr = OS_ERR_FLAG_INVALID_PGRP;
+    return 0;
+  }
+  if (pgrp->OSFlagType != OS_EVENT_TYPE_FLAG) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return 0;
+  }
+  os_host_lock();
+  flags = pgrp->OSFlagFlags;
+  os_host_unlock();
+  *perr = OS_ERR_NONE;
+  return flags;
+}
+
+/*
+ * Time
+ */
+void OSTimeDly(INT16U ticks)
+{
+  if (OSIntNesting > 0 || OSLockNesting > 0 || ticks == 0)
+    return;
+  os_host_lock();
+  OSTCBCur->OSTCBDly = ticks;
+  OS_Sched();
+  os_host_unlock();
+}
+
+INT8U OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds, INT16U ms)
+{
+  INT32U ticks;
+
+  if (OSIntNesting > 0)
+    return OS_ERR_TIME_DLY_ISR;
+  if (hours == 0 && minutes == 0 && seconds == 0 && ms == 0)
+    return OS_ERR_TIME_ZERO_DLY;
+  if (minutes > 59)
+    return OS_ERR_TIME_INVALID_MINUTES;
+  if (seconds > 59)
+    return OS_ERR_TIME_INVALID_SECONDS;
+  if (ms > 999)
+    return OS_ERR_TIME_INVALID_MS;
+
+  ticks = ((INT32U) hours * 3600UL + (INT32U) minutes * 60UL +
+           (INT32U) seconds) * OS_TICKS_PER_SEC
+        + OS_TICKS_PER_SEC * ((INT32U) ms + 500UL / OS_TICKS_PER_SEC) / 1000UL;
+  while (ticks > 65535UL) {
+    OSTimeDly(32768);
+    ticks -= 32768;
+  }
+  OSTimeDly((INT16U) ticks);
+  return OS_ERR_NONE;
+}
+
+INT32U OSTimeGet(void)
+{
+  INT32U ticks;
+
+  os_host_lock();
+  ticks = OSTime;
+  os_host_unlock();
+  return ticks;
+}
+
+/*
+ * Called from the system clock ISR once per tick: expires delays and
+ * pend timeouts.
+ */
+void OSTimeTick(void)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+
+#if OS_APP_HOOKS_EN > 0
+  if (App_TimeTickHook != NULL)
+    App_TimeTickHook();
+#endif
+  os_host_lock();
+  if (OSRunning == FALSE) {
+    os_host_unlock();
+    return;
+  }
+  OSTime++;
+  for (prio = 0; prio < OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb == NULL || ptcb->OSTCBDly == 0)
+      continue;
+    if (--ptcb->OSTCBDly == 0 && (ptcb->OSTCBStat & OS_STAT_PEND_ANY)) {
+      ptcb->OSTCBStat    &= ~OS_STAT_PEND_ANY;
+      ptcb->OSTCBPendTO   = TRUE;
+      ptcb->OSTCBEventPtr = NULL;
+    }
+  }
+  os_host_unlock();
+}
+
+/*
+ * Ticks until the first task delay or pend timeout expires, 0 if no task
+ * waits for one.
+ */
+static INT32U OS_TicksToEvent(void)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+  INT32U ticks = 0;
+
+  for (prio = 0; prio < OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb != NULL && ptcb->OSTCBDly != 0 &&
+        (ticks == 0 || ptcb->OSTCBDly < ticks))
+      ticks = ptcb->OSTCBDly;
+  }
+  return ticks;
+}
+
+/* Lets 'ticks' ticks pass in which no delay or timeout expires */
+static void OS_TimeSkip(INT32U ticks)
+{
+  INT8U prio;
+  OS_TCB *ptcb;
+
+  OSTime += ticks;
+  for (prio = 0; prio < OS_LOWEST_PRIO; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb != NULL && ptcb->OSTCBDly != 0)
+      ptcb->OSTCBDly -= ticks;
+  }
+}
+
+/*
+ * Idle task of virtual time mode: advances the clock to the next event
+ * and raises the tick interrupt there.
+ */
+static void OS_IdleAdvance(void)
+{
+  INT32U ticks = OS_TicksToEvent();
+  INT32U hal = alt_host_clock_ticks_to_event();
+
+  if (hal != 0 && (ticks == 0 || hal < ticks))
+    ticks = hal;
+  if (ticks == 0) {
+    fprintf(stderr, "os_host: every task is blocked for good\n");
+    os_stopping = TRUE;
+    return;
+  }
+  if (ticks > 1) {
+    OS_TimeSkip(ticks - 1);
+    alt_host_clock_skip(ticks - 1);
+  }
+  alt_host_clock_tick();
+}
+
+/*
+ * Interrupts
+ *
+ * The ISR holds the kernel lock from OSIntEnter() to OSIntExit(), which
+ * makes it atomic with respect to the kernel as on the target.
+ */
+void OSIntEnter(void)
+{
+  os_host_lock();
+  if (OSIntNesting < 255)
+    OSIntNesting++;
+}
+
+void OSIntExit(void)
+{
+  OS_TCB *pnext;
+
+  if (OSIntNesting > 0)
+    OSIntNesting--;
+  if (OSIntNesting == 0 && OSLockNesting == 0 && OSRunning &&
+      OSTCBCur == OSTCBIdle && !os_virtual) {
+    pnext = OS_SchedNew();
+    if (pnext != OSTCBIdle)
+      OS_SetCur(pnext);
+  }
+  os_host_unlock();
+}
+
+void OSSchedLock(void)
+{
+  os_host_lock();
+  if (OSRunning && OSIntNesting == 0 && OSLockNesting < 255)
+    OSLockNesting++;
+  os_host_unlock();
+}
+
+void OSSchedUnlock(void)
+{
+  os_host_lock();
+  if (OSRunning && OSIntNesting == 0 && OSLockNesting > 0)
+    OSLockNesting--;
+  os_host_unlock();
+}
+
+INT16U OSVersion(void)
+{
+  return OS_VERSION;
+}
+
+/*
+ * Tasks
+ */
+static void *OS_TaskEntry(void *p_arg)
+{
+  OS_TCB *ptcb = (OS_TCB *) p_arg;
+
+  os_self = ptcb;
+  os_host_lock();
+  OS_WaitDispatch(ptcb);
+  os_host_unlock();
+
+  OS_HOST(ptcb)->task(OS_HOST(ptcb)->p_arg);
+  OSTaskDel(OS_PRIO_SELF);
+  return NULL;
+}
+
+/* First code of a coroutine, entered from OS_CtxSw() of another task */
+static void OS_TaskEntryVirtual(void)
+{
+  OS_TCB *ptcb = OSTCBCur;
+
+  os_self = ptcb;
+  os_lock_depth = 0;
+  OS_HOST(ptcb)->task(OS_HOST(ptcb)->p_arg);
+  OSTaskDel(OS_PRIO_SELF);
+}
+
+static INT8U OS_TCBInit(OS_TCB **pptcb, INT8U prio, OS_STK *pbos,
+                        INT32U stk_size, void *pext, INT16U opt, INT16U id)
+{
+  OS_TCB *ptcb;
+
+  if (OSTCBPrioTbl[prio] != NULL)
+    return OS_ERR_PRIO_EXIST;
+  if (OSTCBUsed >= OS_MAX_TASKS + OS_N_SYS_TASKS)
+    return OS_ERR_TASK_NO_MORE_TCB;
+
+  ptcb = &OSTCBTbl[OSTCBUsed];
+  ptcb->OSTCBHost = &OSHostTbl[OSTCBUsed];
+  OSTCBUsed++;
+
+  ptcb->OSTCBStkPtr    = pbos;
+  ptcb->OSTCBExtPtr    = pext;
+  ptcb->OSTCBStkBottom = pbos;
+  ptcb->OSTCBStkSize   = stk_size;
+  ptcb->OSTCBOpt       = opt;
+  ptcb->OSTCBId        = id;
+  ptcb->OSTCBEventPtr  = NULL;
+  ptcb->OSTCBMsg       = NULL;
+  ptcb->OSTCBDly       = 0;
+  ptcb->OSTCBStat      = OS_STAT_RDY;
+  ptcb->OSTCBPendTO    = FALSE;
+  ptcb->OSTCBPrio      = prio;
+  ptcb->OSTCBCtxSwCtr  = 0;
+  pthread_cond_init(&OS_HOST(ptcb)->run, NULL);
+
+  OSTCBPrioTbl[prio] = ptcb;
+  *pptcb = ptcb;
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskCreateExt(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos,
+                      INT8U prio, INT16U id, OS_STK *pbos, INT32U stk_size,
+                      void *pext, INT16U opt)
+{
+  INT8U err;
+  OS_TCB *ptcb;
+  OS_HOST_TASK *phost;
+  pthread_attr_t attr;
+  size_t bytes;
+
+  (void) ptos;
+  if (prio > OS_LOWEST_PRIO)
+    return OS_ERR_PRIO_INVALID;
+  if (OSIntNesting > 0)
+    return OS_ERR_TASK_CREATE_ISR;
+  if (!os_initialized)
+    OSInit();
+
+  os_host_lock();
+  err = OS_TCBInit(&ptcb, prio, pbos, stk_size, pext, opt, id);
+  if (err != OS_ERR_NONE) {
+    os_host_unlock();
+    return err;
+  }
+  phost = OS_HOST(ptcb);
+  phost->task  = task;
+  phost->p_arg = p_arg;
+
+  /*
+   * The thread gets its own, zero filled stack so OSTaskStkChk() can
+   * measure how much of it the task really touches.
+   */
+  bytes = (size_t) stk_size * sizeof(OS_STK) * OS_HOST_STK_SCALE;
+  if (bytes < (size_t) PTHREAD_STACK_MIN)
+    bytes = PTHREAD_STACK_MIN;
+  phost->stk = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  phost->stk_bytes = bytes;
+  if (phost->stk == MAP_FAILED) {
+    fprintf(stderr, "os_host: no memory for the stack of task %d\n", prio);
+    exit(1);
+  }
+  /* The TCB describes the stack the task really runs on */
+  ptcb->OSTCBStkBottom = (OS_STK *) phost->stk;
+  ptcb->OSTCBStkSize   = bytes / sizeof(OS_STK);
+  if (os_virtual) {
+    getcontext(&phost->ctx);
+    phost->ctx.uc_stack.ss_sp   = phost->stk;
+    phost->ctx.uc_stack.ss_size = bytes;
+    phost->ctx.uc_link          = NULL;
+    makecontext(&phost->ctx, OS_TaskEntryVirtual, 0);
+  } else {
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, phost->stk, bytes);
+    if (pthread_create(&phost->thread, &attr, OS_TaskEntry, ptcb) != 0) {
+      fprintf(stderr, "os_host: cannot create thread for task %d\n", prio);
+      exit(1);
+    }
+    pthread_attr_destroy(&attr);
+  }
+
+  if (OSRunning)
+    OS_Sched();
+  os_host_unlock();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskCreate(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos,
+                   INT8U prio)
+{
+  return OSTaskCreateExt(task, p_arg, ptos, prio, prio, ptos, 1024, NULL,
+                         OS_TASK_OPT_NONE);
+}
+
+INT8U OSTaskDel(INT8U prio)
+{
+  OS_TCB *ptcb;
+
+  if (OSIntNesting > 0)
+    return OS_ERR_TASK_DEL_ISR;
+  if (prio == OS_TASK_IDLE_PRIO)
+    return OS_ERR_TASK_DEL_IDLE;
+  os_host_lock();
+  if (prio == OS_PRIO_SELF)
+    prio = OSTCBCur->OSTCBPrio;
+  ptcb = OSTCBPrioTbl[prio];
+  if (ptcb == NULL) {
+    os_host_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  OSTCBPrioTbl[prio] = NULL;
+  ptcb->OSTCBEventPtr = NULL;
+  ptcb->OSTCBDly      = 0;
+  ptcb->OSTCBStat     = OS_STAT_RDY;
+
+  if (ptcb != OSTCBCur) {
+    /* The thread stays parked for good: it is never dispatched again */
+    os_host_unlock();
+    return OS_ERR_NONE;
+  }
+  OS_SetCur(OS_SchedNew());
+  if (os_virtual)
+    setcontext(&OS_HOST(OSTCBCur)->ctx);
+  os_lock_depth--;
+  pthread_mutex_unlock(&os_mutex);
+  pthread_exit(NULL);
+}
+
+/*
+ * Counts the untouched (zero) words from the bottom of the task's host
+ * stack.  Sizes are in bytes of the host stack, which is
+ * OS_HOST_STK_SCALE times the size requested by the application.
+ */
+INT8U OSTaskStkChk(INT8U prio, OS_STK_DATA *p_stk_data)
+{
+  OS_TCB *ptcb;
+  INT32U *pstk;
+  INT32U nfree = 0, nwords;
+
+  p_stk_data->OSFree = 0;
+  p_stk_data->OSUsed = 0;
+  if (prio > OS_LOWEST_PRIO && prio != OS_PRIO_SELF)
+    return OS_ERR_PRIO_INVALID;
+  os_host_lock();
+  if (prio == OS_PRIO_SELF)
+    prio = OSTCBCur->OSTCBPrio;
+  ptcb = OSTCBPrioTbl[prio];
+  if (ptcb == NULL || OS_HOST(ptcb)->stk == NULL) {
+    os_host_unlock();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  if ((ptcb->OSTCBOpt & OS_TASK_OPT_STK_CHK) == 0) {
+    os_host_unlock();
+    return OS_ERR_TASK_OPT;
+  }
+  pstk   = OS_HOST(ptcb)->stk;
+  nwords = OS_HOST(ptcb)->stk_bytes / sizeof(INT32U);
+  os_host_unlock();
+
+  while (nfree < nwords && *pstk++ == 0)
+    nfree++;
+  p_stk_data->OSFree = nfree * sizeof(INT32U);
+  p_stk_data->OSUsed = (nwords - nfree) * sizeof(INT32U);
+  return OS_ERR_NONE;
+}
+
+/*
+ * Statistic task
+ *
+ * OSIdleCtr counts the microseconds the idle task ran during the last
+ * second, so OSCPUUsage keeps the formula of the target.
+ */
+static void OS_TaskStat(void *p_arg)
+{
+  long long idle_last = 0, idle_now;
+  INT32U usage;
+
+  (void) p_arg;
+  while (OSStatRdy == FALSE)
+    OSTimeDly(2 * OS_TICKS_PER_SEC / 10);
+  OSIdleCtrMax = 1000000UL;
+  os_host_lock();
+  idle_last = os_idle_ns;
+  os_host_unlock();
+  for (;;) {
+    OSTimeDly(OS_TICKS_PER_SEC);
+    os_host_lock();
+    idle_now = os_idle_ns;
+    os_host_unlock();
+    OSIdleCtr = (INT32U) ((idle_now - idle_last) / 1000);
+    if (OSIdleCtr > OSIdleCtrMax)
+      OSIdleCtr = OSIdleCtrMax;
+    idle_last = idle_now;
+    usage = 100UL - OSIdleCtr / (OSIdleCtrMax / 100UL);
+    OSCPUUsage = (INT8U) usage;
+  }
+}
+
+void OSStatInit(void)
+{
+  OSTimeDly(2);
+  os_host_lock();
+  OSStatRdy = TRUE;
+  os_host_unlock();
+}
+
+/*
+ * Software timers
+ *
+ * OSTmrSignal() releases the timer task, which advances OSTmrTime by one
+ * and calls the callbacks of the timers that expire.
+ */
+static void OS_TmrTask(void *p_arg)
+{
+  INT8U err;
+  INT16U i, n;
+  OS_TMR *due[OS_TMR_CFG_MAX];
+
+  (void) p_arg;
+  for (;;) {
+    OSSemPend(OSTmrSemSignal, 0, &err);
+    os_host_lock();
+    OSTmrTime++;
+    n = 0;
+    for (i = 0; i < OS_TMR_CFG_MAX; i++) {
+      OS_TMR *ptmr = &OSTmrTbl[i];
+      if (ptmr->OSTmrState != OS_TMR_STATE_RUNNING ||
+          ptmr->OSTmrMatch != OSTmrTime)
+        continue;
+      if (ptmr->OSTmrOpt == OS_TMR_OPT_PERIODIC)
+        ptmr->OSTmrMatch = OSTmrTime + ptmr->OSTmrPeriod;
+      else
+        ptmr->OSTmrState = OS_TMR_STATE_COMPLETED;
+      due[n++] = ptmr;
+    }
+    os_host_unlock();
+    for (i = 0; i < n; i++)
+      if (due[i]->OSTmrCallback != NULL)
+        due[i]->OSTmrCallback(due[i], due[i]->OSTmrCallbackArg);
+  }
+}
+
+OS_TMR *OSTmrCreate(INT32U dly, INT32U period, INT8U opt,
+                    OS_TMR_CALLBACK callback, void *callback_arg,
+                    INT8U *pname, INT8U *perr)
+{
+  INT16U i;
+  OS_TMR *ptmr = NULL;
+
+  switch (opt) {
+  case OS_TMR_OPT_PERIODIC:
+    if (period == 0) {
+      *perr = OS_ERR_TMR_INVALID_PERIOD;
+      return NULL;
+    }
+    break;
+  case OS_TMR_OPT_ONE_SHOT:
+    if (dly == 0) {
+      *perr = OS_ERR_TMR_INVALID_DLY;
+      return NULL;
+    }
+    break;
+  default:
+    *perr = OS_ERR_TMR_INVALID_OPT;
+    return NULL;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_TMR_ISR;
+    return NULL;
+  }
+  os_host_lock();
+  for (i = 0; i < OS_TMR_CFG_MAX; i++) {
+    if (OSTmrTbl[i].OSTmrState == OS_TMR_STATE_UNUSED) {
+      ptmr = &OSTmrTbl[i];
+      ptmr->OSTmrType        = OS_EVENT_TYPE_UNUSED;
+      ptmr->OSTmrCallback    = callback;
+      ptmr->OSTmrCallbackArg = callback_arg;
+      ptmr->OSTmrDly         = dly;
+      ptmr->OSTmrPeriod      = period;
+      ptmr->OSTmrOpt         = opt;
+      ptmr->OSTmrName        = pname;
+      ptmr->OSTmrState       = OS_TMR_STATE_STOPPED;
+      break;
+    }
+  }
+  os_host_unlock();
+  *perr = ptmr != NULL ? OS_ERR_NONE : OS_ERR_TMR_NON_AVAIL;
+  return ptmr;
+}
+
+BOOLEAN OSTmrStart(OS_TMR *ptmr, INT8U *perr)
+{
+  if (ptmr == NULL) {
+    *perr = OS_ERR_TMR_INVALID;
+    return FALSE;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_TMR_ISR;
+    return FALSE;
+  }
+  os_host_lock();
+  if (ptmr->OSTmrState == OS_TMR_STATE_UNUSED) {
+    os_host_unlock();
+    *perr = OS_ERR_TMR_INACTIVE;
+    return FALSE;
+  }
+  if (ptmr->OSTmrOpt == OS_TMR_OPT_PERIODIC && ptmr->OSTmrDly == 0)
+    ptmr->OSTmrMatch = OSTmrTime + ptmr->OSTmrPeriod;
+  else
+    ptmr->OSTmrMatch = OSTmrTime + ptmr->OSTmrDly;
+  ptmr->OSTmrState = OS_TMR_STATE_RUNNING;
+  os_host_unlock();
+  *perr = OS_ERR_NONE;
+  return TRUE;
+}
+
+BOOLEAN OSTmrStop(OS_TMR *ptmr, INT8U opt, void *callback_arg, INT8U *perr)
+{
+  OS_TMR_CALLBACK callback = NULL;
+
+  if (ptmr == NULL) {
+    *perr = OS_ERR_TMR_INVALID;
+    return FALSE;
+  }
+  if (OSIntNesting > 0) {
+    *perr = OS_ERR_TMR_ISR;
+    return FALSE;
+  }
+  os_host_lock();
+  if (ptmr->OSTmrState != OS_TMR_STATE_RUNNING) {
+    *perr = ptmr->OSTmrState == OS_TMR_STATE_UNUSED ? OS_ERR_TMR_INACTIVE
+                                                    : OS_ERR_TMR_STOPPED;
+    os_host_unlock();
+    return FALSE;
+  }
+  ptmr->OSTmrState = OS_TMR_STATE_STOPPED;
+  if (opt == OS_TMR_OPT_CALLBACK) {
+    callback = ptmr->OSTmrCallback;
+    callback_arg = ptmr->OSTmrCallbackArg;
+  } else if (opt == OS_TMR_OPT_CALLBACK_ARG) {
+    callback = ptmr->OSTmrCallback;
+  }
+  os_host_unlock();
+  if (callback != NULL)
+    callback(ptmr, callback_arg);
+  *perr = OS_ERR_NONE;
+  return TRUE;
+}
+
+INT8U OSTmrSignal(void)
+{
+  return OSSemPost(OSTmrSemSignal);
+}
+
+/*
+ * Start-up
+ */
+void OSInit(void)
+{
+  pthread_mutexattr_t attr;
+  INT8U err;
+
+  if (os_initialized)
+    return;
+  os_initialized = TRUE;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&os_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  /* The idle task is backed by the thread that later calls OSStart() */
+  os_host_lock();
+  OS_TCBInit(&OSTCBIdle, OS_TASK_IDLE_PRIO, NULL, 0, NULL,
+             OS_TASK_OPT_NONE, OS_TASK_IDLE_PRIO);
+  os_host_unlock();
+
+  OSTmrSemSignal = OSSemCreate(0);
+  err = OSTaskCreateExt(OS_TmrTask, NULL, &OSTaskTmrStk[1023],
+                        OS_TASK_TMR_PRIO, OS_TASK_TMR_PRIO, OSTaskTmrStk,
+                        1024, NULL, OS_TASK_OPT_STK_CHK);
+  if (err == OS_ERR_NONE)
+    err = OSTaskCreateExt(OS_TaskStat, NULL, &OSTaskStatStk[1023],
+                          OS_TASK_STAT_PRIO, OS_TASK_STAT_PRIO,
+                          OSTaskStatStk, 1024, NULL, OS_TASK_OPT_STK_CHK);
+  if (err != OS_ERR_NONE) {
+    fprintf(stderr, "os_host: cannot create the system tasks (%d)\n", err);
+    exit(1);
+  }
+}
+
+/*
+ * Starts multitasking; the calling thread becomes the idle task and only
+ * leaves through exit() once os_host_stop() was requested.
+ */
+void OSStart(void)
+{
+  if (!os_initialized)
+    OSInit();
+  os_host_lock();
+  if (OSRunning) {
+    os_host_unlock();
+    return;
+  }
+  os_self       = OSTCBIdle;
+  OSTCBCur      = OSTCBIdle;
+  os_idle_since = os_host_now_ns();
+  OSRunning     = TRUE;
+
+  for (;;) {
+    if (OSTCBCur == OSTCBIdle) {
+      OS_TCB *pnext = OS_SchedNew();
+      if (pnext != OSTCBIdle) {
+        OS_CtxSw(pnext);
+        continue;
+      }
+      if (os_stopping) {
+        fflush(stdout);
+        exit(0);
+      }
+#if OS_APP_HOOKS_EN > 0
+      if (App_TaskIdleHook != NULL)
+        App_TaskIdleHook();
+#endif
+      alt_host_idle();
+      if (os_virtual) {
+        OS_IdleAdvance();
+        continue;
+      }
+    }
+    pthread_cond_wait(&OS_HOST(OSTCBIdle)->run, &os_mutex);
+  }
+}
@@ -0,0 +1,307 @@
+/*
+ * Offline schedulability analysis of a fixed priority task set
+ *
+ *   rta [-s <task>] [-u <us>] <table>
+ *
+ * The table has one task per line (see ../cruise_tasks.tbl):
+ *
+ *   <name> <prio> <period_ms> <wcet_us> [<blocking_us> [<deadline_ms>]]
+ *
+ * A lower prio number is a higher priority, as in uC/OS-II; the deadline
+ * defaults to the period, and a deadline of '-' is none (e.g. OS_TaskStat).
+ * The program prints the worst-case response time of every task
+ * (response-time analysis for preemptive fixed priority scheduling, over
+ * all jobs of the level-i busy period, so deadlines may exceed periods),
+ * the utilization against the rate monotonic bound and the same analysis
+ * for a rate monotonic assignment of the task priorities in use (deadline
+ * monotonic where a deadline differs from the period).  ISRs, prio < 0,
+ * and the tasks of uC/OS-II, named OS_*, keep their priorities.
+ *
+ * -s <task> also searches the largest WCET of <task> that keeps the set
+ * schedulable; with -u <us> it is printed in units of <us> as well (e.g.
+ * the cost of one unit of ExtraLoad's 'usage').
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define RTA_MAX_TASKS 64
+#define RTA_NAME_LEN  32
+
+typedef struct rta_task {
+  char   name[RTA_NAME_LEN];
+  int    prio;
+  double period;        /* us */
+  double wcet;          /* us */
+  double blocking;      /* us */
+  double deadline;      /* us, HUGE_VAL if none */
+  int    fixed;         /* keeps its priority in the RM assignment */
+  double response;      /* us, result, HUGE_VAL if unbounded */
+  int    ok;
+} rta_task;
+
+static rta_task rta_tasks[RTA_MAX_TASKS];
+static int      rta_num;
+
+static void rta_load(const char *path)
+{
+  char line[256], name[RTA_NAME_LEN], dl[16];
+  double period, wcet, blocking, deadline;
+  int prio, n, lineno = 0;
+  FILE *f = fopen(path, "r");
+
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f) != NULL) {
+    lineno++;
+    line[strcspn(line, "#\n")] = '\0';
+    blocking = 0;
+    n = sscanf(line, "%31s %d %lf %lf %lf %15s", name, &prio, &period, &wcet,
+               &blocking, dl);
+    if (n <= 0)
+      continue;
+    if (n == 6)
+      deadline = strcmp(dl, "-") == 0 ? HUGE_VAL : atof(dl);
+    else
+      deadline = period;
+    if (n < 4 || period <= 0 || wcet < 0 || deadline <= 0) {
+      fprintf(stderr, "%s:%d: expected <name> <prio> <period_ms> <wcet_us>"
+              " [<blocking_us> [<deadline_ms>]]\n", path, lineno);
+      exit(1);
+    }
+    if (rta_num == RTA_MAX_TASKS) {
+      fprintf(stderr, "%s:%d: more than %d tasks\n", path, lineno,
+              RTA_MAX_TASKS);
+      exit(1);
+    }
+    strcpy(rta_tasks[rta_num].name, name);
+    rta_tasks[rta_num].prio     = prio;
+    rta_tasks[rta_num].period   = period * 1000;
+    rta_tasks[rta_num].wcet     = wcet;
+    rta_tasks[rta_num].blocking = blocking;
+    rta_tasks[rta_num].deadline = deadline * 1000;
+    rta_tasks[rta_num].fixed    = prio < 0 || strncmp(name, "OS_", 3) == 0;
+    rta_num++;
+  }
+  fclose(f);
+}
+
+/* Time demand of the higher priority tasks than 'i' within 'w' us */
+static double rta_interference(const rta_task *t, int num, int i, double w)
+{
+  double sum = 0;
+  int j;
+
+  for (j = 0; j < num; j++)
+    if (j != i && t[j].prio <= t[i].prio)
+      sum += ceil(w / t[j].period) * t[j].wcet;
+  return sum;
+}
+
+/*
+ * The level-i busy period L = B + ceil(L / T_i) * C_i + I(L) holds
+ * Q = ceil(L / T_i) jobs of task i.  Job q (from 0) completes at
+ *
+ *   w_q = B + (q + 1) * C_i + I(w_q)
+ *
+ * (I: sum over the higher priority tasks j of ceil(w / T_j) * C_j), and
+ * R = max over q of w_q - q * T_i.  With D <= T only job 0 counts; with
+ * D > T a job may still run when the next one is released.  Each w_q is
+ * iterated until it is stable or job q misses the deadline.  Tasks of
+ * equal priority count as interference both ways.  If the tasks down to
+ * level i use the whole CPU the busy period never ends: R is unbounded.
+ */
+static int rta_analyze(rta_task *t, int num)
+{
+  int i, j, q, jobs, all_ok = 1;
+  double u, w, next, busy;
+
+  for (i = 0; i < num; i++) {
+    u = t[i].wcet / t[i].period;
+    for (j = 0; j < num; j++)
+      if (j != i && t[j].prio <= t[i].prio)
+        u += t[j].wcet / t[j].period;
+    t[i].response = HUGE_VAL;
+    if (u < 1) {
+      next = t[i].wcet + t[i].blocking;
+      do {
+        busy = next;
+        next = t[i].blocking + ceil(busy / t[i].period) * t[i].wcet +
+               rta_interference(t, num, i, busy);
+      } while (next != busy);
+      jobs = (int) ceil(busy / t[i].period);
+      t[i].response = 0;
+      for (q = 0; q < jobs; q++) {
+        next = t[i].blocking + (q + 1) * t[i].wcet;
+        do {
+          w = next;
+          next = t[i].blocking + (q + 1) * t[i].wcet +
+                 rta_interference(t, num, i, w);
+        } while (next != w && next - q * t[i].period <= t[i].deadline);
+        if (next - q * t[i].period > t[i].response)
+          t[i].response = next - q * t[i].period;
+        if (t[i].response > t[i].deadline)
+          break;
+      }
+    }
+    t[i].ok = t[i].deadline == HUGE_VAL || t[i].response <= t[i].deadline;
+    all_ok &= t[i].ok;
+  }
+  return all_ok;
+}
+
+static double rta_utilization(const rta_task *t, int num)
+{
+  double u = 0;
+  int i;
+
+  for (i = 0; i < num; i++)
+    u += t[i].wcet / t[i].period;
+  return u;
+}
+
+static int rta_by_prio(const void *a, const void *b)
+{
+  return ((const rta_task *) a)->prio - ((const rta_task *) b)->prio;
+}
+
+static int rta_by_deadline(const void *a, const void *b)
+{
+  const rta_task *x = a, *y = b;
+
+  if (x->deadline != y->deadline)
+    return x->deadline < y->deadline ? -1 : 1;
+  return x->prio - y->prio;
+}
+
+static void rta_print(const rta_task *t, int num)
+{
+  char deadline[16], response[16];
+  int i;
+
+  printf("%-18s %5s %10s %10s %10s %11s %10s %8s\n", "task", "prio",
+         "period_ms", "wcet_us", "block_us", "deadline_ms", "resp_us", "");
+  for (i = 0; i < num; i++) {
+    if (t[i].deadline == HUGE_VAL)
+      strcpy(deadline, "-");
+    else
+      sprintf(deadline, "%.1f", t[i].deadline / 1000);
+    if (t[i].response == HUGE_VAL)
+      strcpy(response, "unbounded");
+    else
+      sprintf(response, "%.0f", t[i].response);
+    printf("%-18s %5d %10.1f %10.0f %10.0f %11s %10s %8s\n", t[i].name,
+           t[i].prio, t[i].period / 1000, t[i].wcet, t[i].blocking, deadline,
+           response, t[i].deadline == HUGE_VAL ? "" :
+           t[i].ok ? "met" : "MISSED");
+  }
+}
+
+/* Largest WCET of task 'k' (us) with which the set is schedulable */
+static double rta_breakdown(int k)
+{
+  rta_task t[RTA_MAX_TASKS];
+  double lo = 0, hi = rta_tasks[k].period, mid;
+
+  memcpy(t, rta_tasks, sizeof(t));
+  t[k].wcet = 0;
+  if (!rta_analyze(t, rta_num))
+    return -1;
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    t[k].wcet = mid;
+    if (rta_analyze(t, rta_num))
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+int main(int argc, char **argv)
+{
+  rta_task rm[RTA_MAX_TASKS], moved[RTA_MAX_TASKS];
+  int prios[RTA_MAX_TASKS];
+  const char *scale = NULL, *path = NULL;
+  double unit = 0, u, bound, wcet;
+  int i, n, ok, ok_rm, k = -1;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+      scale = argv[++i];
+    else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+      unit = atof(argv[++i]);
+    else if (path == NULL && argv[i][0] != '-')
+      path = argv[i];
+    else {
+      fprintf(stderr, "usage: %s [-s <task>] [-u <us>] <table>\n", argv[0]);
+      return 2;
+    }
+  }
+  if (path == NULL) {
+    fprintf(stderr, "usage: %s [-s <task>] [-u <us>] <table>\n", argv[0]);
+    return 2;
+  }
+  rta_load(path);
+  if (rta_num == 0) {
+    fprintf(stderr, "%s: no tasks\n", path);
+    return 1;
+  }
+
+  qsort(rta_tasks, rta_num, sizeof(rta_task), rta_by_prio);
+  ok = rta_analyze(rta_tasks, rta_num);
+  u = rta_utilization(rta_tasks, rta_num);
+  bound = rta_num * (pow(2.0, 1.0 / rta_num) - 1);
+
+  printf("Response-time analysis, priorities of the table\n\n");
+  rta_print(rta_tasks, rta_num);
+  printf("\nUtilization %.3f, rate monotonic bound for %d tasks %.3f (%s)\n",
+         u, rta_num, bound, u <= bound ? "below" : "above");
+  printf("Task set is %sschedulable\n", ok ? "" : "NOT ");
+
+  /*
+   * Rate monotonic: the priority numbers of the tasks that may move,
+   * handed out among them by deadline (none comes last).
+   */
+  memcpy(rm, rta_tasks, sizeof(rm));
+  for (i = n = 0; i < rta_num; i++)
+    if (!rta_tasks[i].fixed) {
+      prios[n] = rta_tasks[i].prio;
+      moved[n++] = rta_tasks[i];
+    }
+  qsort(moved, n, sizeof(rta_task), rta_by_deadline);
+  for (i = n = 0; i < rta_num; i++)
+    if (!rta_tasks[i].fixed) {
+      rm[i] = moved[n];
+      rm[i].prio = prios[n++];
+    }
+  qsort(rm, rta_num, sizeof(rta_task), rta_by_prio);
+  ok_rm = rta_analyze(rm, rta_num);
+  printf("\nRate monotonic assignment of the same priorities\n\n");
+  rta_print(rm, rta_num);
+  printf("\nTask set is %sschedulable with it\n", ok_rm ? "" : "NOT ");
+
+  if (scale != NULL) {
+    for (i = 0; i < rta_num; i++)
+      if (strcmp(rta_tasks[i].name, scale) == 0)
+        k = i;
+    if (k < 0) {
+      fprintf(stderr, "%s: no task '%s'\n", path, scale);
+      return 1;
+    }
+    wcet = rta_breakdown(k);
+    if (wcet < 0)
+      printf("\nNot schedulable even with a WCET of 0 for %s\n", scale);
+    else {
+      printf("\nLargest WCET of %s: %.0f us (utilization %.3f)", scale, wcet,
+             u + (wcet - rta_tasks[k].wcet) / rta_tasks[k].period);
+      if (unit > 0)
+        printf(", %.0f units of %.1f us", floor(wcet / unit), unit);
+      printf("\n");
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define SIM_CHUNK   16          /* Jobs a worker takes at a time */
+#define SIM_THREADS 256
+
+#if CRUISE_CONTROLLER == 1
+#define SIM_PID(c) (&(c)->pid_ff)
+#else
+#define SIM_PID(c) (&(c)->pid.p)
+#endif
+#if CRUISE_CONTROLLER == 1 || CRUISE_FIXED_POINT
+#define SIM_GAIN(k) PID_GAIN(k)
+#else
+#define SIM_GAIN(k) (k)
+#endif
+
+/* The gains per PID_TUNED_PERIOD, scaled to CONTROL_PERIOD */
+static void sim_set_gains(struct cruise_controller *c,
+                          const struct sim_gains *g)
+{
+#if CRUISE_CONTROLLER == 2
+  (void) c;
+  (void) g;
+#else
+  SIM_PID(c)->Kp = SIM_GAIN(g->kp);
+  SIM_PID(c)->Ki = SIM_GAIN(g->ki * CONTROL_PERIOD / PID_TUNED_PERIOD);
+  SIM_PID(c)->Kd = SIM_GAIN(g->kd * PID_TUNED_PERIOD / CONTROL_PERIOD);
+#endif
+}
+
+void sim_run(const struct sim_gains *gains, const struct sim_scenario *s,
+             struct sim_result *r)
+{
+  struct cruise_vehicle v;
+  struct cruise_controller c;
+  struct input_snapshot in;
+  INT32U ms, now, change = 0, last_out = 0, last_position, driven = 0;
+  INT32U err, settle;
+  INT16U segment;
+  INT16S goal;
+  INT8U throttle = 0, t;
+  enum active cruising;
+
+  memset(r, 0, sizeof(*r));
+  cruise_vehicle_init(&v);
+  cruise_vehicle_set(&v, s->start, s->velocity);
+  v.drag  = &s->drag;
+  v.slope = s->slope;
+  cruise_controller_init(&c);
+  sim_set_gains(&c, gains);
+#if CRUISE_CONTROLLER == 1 || CRUISE_CONTROLLER == 2
+  c.slope = s->slope;
+#endif
+  memset(&in, 0, sizeof(in));
+  in.engine      = on;
+  in.top_gear    = on;
+  in.brake_pedal = off;
+  last_position  = v.plant.position;
+
+  for (ms = 0; ms < s->max_ms; ms += VEHICLE_PERIOD) {
+    if (ms % CONTROL_PERIOD == 0) {
+      /* The driver, then ControlTask */
+      goal = r->engaged ? r->target :
+             ms >= s->engage_ms ? SIM_ENGAGE_MIN : s->driver_velocity;
+      in.cruise_button = ms >= s->engage_ms ? on : off;
+      in.gas_pedal = c.cruise_control == off && v.plant.velocity < goal ?
+                     on : off;
+      cruising = c.cruise_control;
+      t = cruise_controller_step(&c, &in, v.plant.position,
+                                 v.plant.velocity);
+      if (!r->engaged && c.cruise_control == on) {
+        r->engaged   = 1;
+        r->target    = c.target_vel;
+        r->engage_ms = ms;
+        change = last_out = ms;
+      } else if (r->engaged && cruising == on && c.cruise_control == off) {
+        r->dropouts++;
+      }
+      if (r->engaged) {
+        r->effort += t > throttle ? t - throttle : throttle - t;
+        r->control_steps++;
+      }
+      throttle = t;
+    }
+
+    segment = v.segment;
+    cruise_vehicle_step(&v, throttle, off, VEHICLE_PERIOD);
+    now = ms + VEHICLE_PERIOD;
+    if (!r->engaged) {
+      last_position = v.plant.position;
+      continue;
+    }
+    /* Forward only: a vehicle that stalls on a hill rolls back */
+    if (v.plant.velocity > 0)
+      driven += v.plant.position >= last_position ?
+        v.plant.position - last_position :
+        v.plant.position + track_length - last_position;
+    last_position = v.plant.position;
+    if (driven >= s->distance) {
+      r->finished = 1;
+      break;
+    }
+    if (v.segment != segment) {
+      /* Settled after the last step out of the band */
+      settle = last_out > change ? last_out - change : 0;
+      r->settle_ms += settle;
+      if (settle > r->settle_max_ms)
+        r->settle_max_ms = settle;
+      r->changes++;
+      change = last_out = now;
+    }
+    err = v.plant.velocity > r->target ? v.plant.velocity - r->target :
+                                         r->target - v.plant.velocity;
+    if (err > r->max_error)
+      r->max_error = err;
+    if (err > SIM_BAND)
+      last_out = now;
+    if (throttle == SIM_THROTTLE_MAX)
+      r->saturated_ms += VEHICLE_PERIOD;
+  }
+}
+
+unsigned long long sim_random(unsigned long long *state)
+{
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Worker pool: the threads take chunks of the jobs until all are done
+ */
+struct sim_pool {
+  sim_job         job;
+  void           *context;
+  int             num;
+  int             next;
+  pthread_mutex_t lock;
+};
+
+static void *sim_worker(void *arg)
+{
+  struct sim_pool *pool = arg;
+  int i, end;
+
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    i = pool->next;
+    pool->next += SIM_CHUNK;
+    pthread_mutex_unlock(&pool->lock);
+    if (i >= pool->num)
+      return NULL;
+    end = i + SIM_CHUNK < pool->num ? i + SIM_CHUNK : pool->num;
+    for (; i < end; i++)
+      pool->job(pool->context, i);
+  }
+}
+
+void sim_parallel(int num, int threads, sim_job job, void *context)
+{
+  struct sim_pool pool = { job, context, num, 0, PTHREAD_MUTEX_INITIALIZER };
+  pthread_t thread[SIM_THREADS];
+  int i;
+
+  if (threads > (num + SIM_CHUNK - 1) / SIM_CHUNK)
+    threads = (num + SIM_CHUNK - 1) / SIM_CHUNK;
+  if (threads > SIM_THREADS)
+    threads = SIM_THREADS;
+  for (i = 1; i < threads; i++)
+    if (pthread_create(&thread[i], NULL, sim_worker, &pool) != 0) {
+      perror("pthread_create");
+      exit(1);
+    }
+  sim_worker(&pool);
+  for (i = 1; i < threads; i++)
+    pthread_join(thread[i], NULL);
+}
+
+int sim_cores(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return n < 1 ? 1 : (int) n;
+}
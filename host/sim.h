@@ -0,0 +1,90 @@
+/*
+ * Closed loop of VehicleTask and ControlTask without the kernel, for the
+ * host tools (tune_pid, monte_carlo, bench_terrain)
+ *
+ * sim_run() steps a struct cruise_controller every CONTROL_PERIOD and a
+ * struct cruise_vehicle every VEHICLE_PERIOD with the steps the tasks
+ * call (cruise.h), so the engagement rule, the gas pedal ramp and the
+ * controller of CRUISE_CONTROLLER are those of ControlTask.  The vehicle
+ * has the drag and the slopes of the scenario, which the feedforward and
+ * the look-ahead controller know as well.  A driver works the inputs:
+ * the engine is on and the top gear in from the start; until
+ * 'engage_ms' the gas pedal is down below 'driver_velocity', from then
+ * on KEY1 is held and the gas pedal released from 20 m/s, so the cruise
+ * control engages at the first control step with a velocity of at least
+ * 20 m/s and holds that velocity.  With an 'engage_ms' of 0 it holds the
+ * initial velocity from the start.  Should the cruise control go off
+ * below 20 m/s, the driver gives gas up to the target and it engages
+ * again.
+ *
+ * sim_parallel() runs a number of independent jobs on a pool of threads.
+ */
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "cruise.h"
+#include "track.h"
+
+#define SIM_ENGAGE_MIN 200      /* Cruise control from 20 m/s, 0.1 m/s */
+#define SIM_BAND       10       /* Settled within 1.0 m/s */
+#define SIM_THROTTLE_MAX 80
+
+#if CONTROL_PERIOD % VEHICLE_PERIOD
+#error "sim.c needs CONTROL_PERIOD to be a multiple of VEHICLE_PERIOD"
+#endif
+
+/*
+ * Gains of the PID of the controller (PID_K* or PID_FF_K*), per
+ * PID_TUNED_PERIOD; the look-ahead controller has none
+ */
+struct sim_gains {
+  double kp, ki, kd;
+};
+
+#if CRUISE_CONTROLLER == 1
+#define SIM_GAINS { PID_FF_KP, PID_FF_KI, PID_FF_KD }
+#else
+#define SIM_GAINS { PID_KP, PID_KI, PID_KD }
+#endif
+
+struct sim_scenario {
+  struct vehicle_drag drag;
+  const INT8S *slope;           /* Of each track segment, NULL: the table */
+  INT32U       start;           /* Position, 0.1 m */
+  INT16S       velocity;        /* Initial velocity, 0.1 m/s */
+  INT16S       driver_velocity; /* 0.1 m/s */
+  INT32U       engage_ms;
+  INT32U       distance;        /* Driven with the cruise control, 0.1 m */
+  INT32U       max_ms;          /* The run ends here at the latest */
+};
+
+struct sim_result {
+  INT8U  engaged;
+  INT8U  finished;              /* The distance was driven */
+  INT16S target;                /* Cruise velocity, 0.1 m/s */
+  INT32U engage_ms;
+  /* From the engagement on */
+  INT32U max_error;             /* Largest |velocity - target|, 0.1 m/s */
+  INT32U settle_ms;             /* Sum over the slope changes */
+  INT32U settle_max_ms;         /* Longest of a slope change */
+  INT32U changes;               /* Slope changes */
+  INT32U effort;                /* Sum of |throttle change|, 0.1 V */
+  INT32U control_steps;
+  INT32U saturated_ms;          /* Time at SIM_THROTTLE_MAX */
+  INT32U dropouts;              /* The cruise control went off */
+};
+
+void sim_run(const struct sim_gains *gains, const struct sim_scenario *s,
+             struct sim_result *r);
+
+/* splitmix64: a well mixed stream of numbers from any seed */
+unsigned long long sim_random(unsigned long long *state);
+
+typedef void (*sim_job)(void *context, int index);
+
+/* Calls job(context, i) for i = 0 .. num - 1 on 'threads' threads */
+void sim_parallel(int num, int threads, sim_job job, void *context);
+
+int  sim_cores(void);
+
+#endif /* SIM_H_ */
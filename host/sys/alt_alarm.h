@@ -0,0 +1,28 @@
+/*
+ * Host (Linux) stand-in for the Nios II HAL 'sys/alt_alarm.h'.
+ *
+ * Alarms are driven by the system clock tick of alt_host.c.
+ */
+#ifndef __ALT_ALARM_H__
+#define __ALT_ALARM_H__
+
+#include "alt_types.h"
+
+typedef struct alt_alarm_s alt_alarm;
+
+struct alt_alarm_s {
+  alt_alarm *next;
+  alt_u32    time;               /* Tick at which the alarm expires */
+  alt_u32  (*callback)(void *context);
+  void      *context;
+  int        armed;
+};
+
+int     alt_alarm_start(alt_alarm *alarm, alt_u32 nticks,
+                        alt_u32 (*callback)(void *context), void *context);
+void    alt_alarm_stop(alt_alarm *alarm);
+
+alt_u32 alt_ticks_per_second(void);
+alt_u32 alt_nticks(void);
+
+#endif /* __ALT_ALARM_H__ */
@@ -0,0 +1,23 @@
+/*
+ * Host (Linux) stand-in for the Nios II HAL 'sys/alt_irq.h'.
+ *
+ * Disabling interrupts takes the kernel lock of the host port, which also
+ * keeps the tick of alt_host.c out.  Registered handlers are called by
+ * alt_host.c inside the timer interrupt, right after an input change.
+ */
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+#include "alt_types.h"
+
+typedef int alt_irq_context;
+
+typedef void (*alt_isr_func)(void *isr_context, alt_u32 id);
+
+int             alt_irq_register(alt_u32 id, void *context,
+                                 alt_isr_func handler);
+
+alt_irq_context alt_irq_disable_all(void);
+void            alt_irq_enable_all(alt_irq_context context);
+
+#endif /* __ALT_IRQ_H__ */
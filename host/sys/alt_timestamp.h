@@ -0,0 +1,18 @@
+/*
+ * Host (Linux) stand-in for the Nios II HAL 'sys/alt_timestamp.h'.
+ *
+ * The timestamp counts nanoseconds (see alt_host.c for virtual time
+ * mode); on the board it counts cycles of the timestamp timer.
+ */
+#ifndef __ALT_TIMESTAMP_H__
+#define __ALT_TIMESTAMP_H__
+
+#include "alt_types.h"
+
+typedef alt_u64 alt_timestamp_type;
+
+int                alt_timestamp_start(void);
+alt_timestamp_type alt_timestamp(void);
+alt_u32            alt_timestamp_freq(void);
+
+#endif /* __ALT_TIMESTAMP_H__ */
@@ -0,0 +1,26 @@
+/*
+ * Host (Linux) stand-in for the 'system.h' generated for the DE2 board.
+ *
+ * The PIO base addresses select registers of the virtual register file in
+ * alt_host.c; each PIO core occupies 16 bytes as on the Avalon bus.
+ */
+#ifndef __SYSTEM_H_
+#define __SYSTEM_H_
+
+#define ALT_CPU_FREQ              50000000
+#define ALT_HOST                  1     /* alt_host.h is available */
+#define ALT_HOST_PIO_SPAN         16
+
+#define DE2_PIO_KEYS4_BASE        0x0000
+#define DE2_PIO_KEYS4_IRQ         5
+#define DE2_PIO_TOGGLES18_BASE    0x0010
+#define DE2_PIO_TOGGLES18_IRQ     6
+#define DE2_PIO_REDLED18_BASE     0x0020
+#define DE2_PIO_GREENLED9_BASE    0x0030
+#define DE2_PIO_HEX_LOW28_BASE    0x0040
+#define DE2_PIO_HEX_HIGH28_BASE   0x0050
+
+#define ALT_HOST_PIO_NUM          6
+#define ALT_HOST_IRQ_NUM          32
+
+#endif /* __SYSTEM_H_ */
@@ -0,0 +1,259 @@
+/*
+ * PID gain tuner for the cruise control (host only)
+ *
+ * Runs the closed loop of VehicleTask and ControlTask without the kernel
+ * (sim.c) on the track of TRACK_TABLE.  The vehicle starts at the target
+ * velocity with the cruise control engaged and drives the track for a
+ * number of laps at each target velocity of tune_target[].
+ *
+ * A candidate (Kp, Ki, Kd) is scored on
+ *
+ *   settling   mean time after a change of slope until the velocity stays
+ *              within SIM_BAND of the target, in s (a segment that is
+ *              left before it settles counts in full)
+ *   overshoot  largest deviation from the target, in m/s
+ *   effort     mean change of the throttle per control step, in V
+ *
+ *   score = settling + w_overshoot * overshoot + w_effort * effort
+ *
+ * The gains are given per PID_TUNED_PERIOD, as PID_KP, PID_KI and PID_KD
+ * in cruise_config.h, and scaled to CONTROL_PERIOD the same way.  The
+ * search evaluates a grid that is logarithmic in each gain, then refines
+ * the best grid points by a pattern search (Hooke-Jeeves without the
+ * pattern move) in the logarithm of the gains.  The candidates of a grid
+ * or of a round of the pattern search are evaluated by one thread per
+ * core.
+ *
+ *   tune_pid [-j threads] [-g points per axis] [-l laps]
+ *            [-o w_overshoot] [-e w_effort]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#if CRUISE_CONTROLLER != 0
+#error "tune_pid tunes the PID controller, CRUISE_CONTROLLER 0"
+#endif
+
+#define TUNE_STARTS    4        /* Grid points refined by the pattern search */
+#define TUNE_ROUNDS    60
+#define TUNE_STEP_MIN  0.01     /* Smallest step of the search, ln(gain) */
+#define TUNE_STALLED   1e9      /* Score of a vehicle that does not finish */
+
+/* Gain ranges of the grid, per PID_TUNED_PERIOD */
+static const double tune_min[3] = { 1.0,   0.005, 0.01 };
+static const double tune_max[3] = { 200.0, 2.0,   20.0 };
+static const char  *tune_axis[3] = { "Kp", "Ki", "Kd" };
+
+/* Cruise targets, 0.1 m/s */
+static const INT16S tune_target[] = { 200, 300, 350 };
+#define TUNE_TARGETS (sizeof(tune_target) / sizeof(tune_target[0]))
+
+struct tune_cand {
+  double k[3];          /* Kp, Ki, Kd */
+  double settling;      /* s */
+  double overshoot;     /* m/s */
+  double effort;        /* V per control step */
+  double score;
+};
+
+static int    tune_laps = 2;
+static double tune_w_overshoot = 1.0;
+static double tune_w_effort = 10.0;
+static int    tune_jobs;
+
+static void tune_eval(struct tune_cand *c)
+{
+  struct sim_scenario sc = { { VEHICLE_WIND_DIV, VEHICLE_ROLLING } };
+  struct sim_result r;
+  struct sim_gains gains = { c->k[0], c->k[1], c->k[2] };
+  INT32U settle_ms = 0, changes = 0, overshoot = 0, effort = 0, steps = 0;
+  unsigned i;
+
+  c->score = 0;
+  for (i = 0; i < TUNE_TARGETS; i++) {
+    sc.velocity = tune_target[i];
+    sc.distance = (INT32U) tune_laps * track_length;
+    /* Three times the time the laps take at the target */
+    sc.max_ms   = 3 * (sc.distance / tune_target[i] * 1000);
+    sim_run(&gains, &sc, &r);
+    if (!r.finished)
+      c->score = TUNE_STALLED;
+    settle_ms += r.settle_ms;
+    changes   += r.changes;
+    effort    += r.effort;
+    steps     += r.control_steps;
+    if (r.max_error > overshoot)
+      overshoot = r.max_error;
+  }
+  c->settling  = changes ? settle_ms / 1000.0 / changes : 0;
+  c->overshoot = overshoot / 10.0;
+  c->effort    = steps ? effort / 10.0 / steps : 0;
+  c->score    += c->settling + tune_w_overshoot * c->overshoot +
+                 tune_w_effort * c->effort;
+}
+
+static INT32U tune_evals;
+
+static void tune_job(void *context, int index)
+{
+  tune_eval(&((struct tune_cand *) context)[index]);
+}
+
+static void tune_eval_batch(struct tune_cand *cand, int num)
+{
+  sim_parallel(num, tune_jobs, tune_job, cand);
+  tune_evals += num;
+}
+
+static int tune_by_score(const void *a, const void *b)
+{
+  double x = ((const struct tune_cand *) a)->score;
+  double y = ((const struct tune_cand *) b)->score;
+
+  return x < y ? -1 : x > y;
+}
+
+static void tune_print(const char *name, const struct tune_cand *c)
+{
+  printf("%-10s %8.3f %7.4f %7.3f %9.2f %9.2f %7.3f %8.2f\n", name,
+         c->k[0], c->k[1], c->k[2], c->settling, c->overshoot, c->effort,
+         c->score);
+}
+
+/*
+ * Pattern search from each start: each round tries one step up and down
+ * in each gain, moves to the best candidate that improves the score and
+ * halves the step when none does
+ */
+static void tune_refine(struct tune_cand *start, int starts, double step0)
+{
+  struct tune_cand trial[TUNE_STARTS * 6], *best;
+  double step[TUNE_STARTS];
+  int s, a, d, n, round, active;
+
+  for (s = 0; s < starts; s++)
+    step[s] = step0;
+  for (round = 0; round < TUNE_ROUNDS; round++) {
+    n = 0;
+    for (s = 0; s < starts; s++) {
+      if (step[s] < TUNE_STEP_MIN)
+        continue;
+      for (a = 0; a < 3; a++)
+        for (d = -1; d <= 1; d += 2) {
+          trial[n] = start[s];
+          trial[n].k[a] *= exp(d * step[s]);
+          n++;
+        }
+    }
+    if (n == 0)
+      break;
+    tune_eval_batch(trial, n);
+
+    n = 0;
+    for (s = 0; s < starts; s++) {
+      if (step[s] < TUNE_STEP_MIN)
+        continue;
+      best = &start[s];
+      for (a = 0; a < 6; a++, n++)
+        if (trial[n].score < best->score)
+          best = &trial[n];
+      if (best != &start[s])
+        start[s] = *best;
+      else
+        step[s] /= 2;
+    }
+    for (s = active = 0; s < starts; s++)
+      active += step[s] >= TUNE_STEP_MIN;
+    if (!active)
+      break;
+  }
+}
+
+static double tune_now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+  struct tune_cand *grid, grid_best, current = { { PID_KP, PID_KI, PID_KD } };
+  int points = 16, n, i, j, a, opt;
+  double t0, t_grid, t_end, step;
+
+  tune_jobs = sim_cores();
+  while ((opt = getopt(argc, argv, "j:g:l:o:e:")) != -1) {
+    switch (opt) {
+    case 'j': tune_jobs = atoi(optarg); break;
+    case 'g': points = atoi(optarg); break;
+    case 'l': tune_laps = atoi(optarg); break;
+    case 'o': tune_w_overshoot = atof(optarg); break;
+    case 'e': tune_w_effort = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-j threads] [-g points per axis] "
+              "[-l laps] [-o w_overshoot] [-e w_effort]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (tune_jobs < 1)
+    tune_jobs = 1;
+  if (points < 2 || tune_laps < 1) {
+    fprintf(stderr, "%s: at least 2 points and 1 lap\n", argv[0]);
+    return 1;
+  }
+
+  printf("Track of %lu.%lu km, %d laps at", (unsigned long) track_length / 10000,
+         (unsigned long) track_length / 1000 % 10, tune_laps);
+  for (i = 0; i < (int) TUNE_TARGETS; i++)
+    printf(" %d", tune_target[i] / 10);
+  printf(" m/s; vehicle %d ms, control %d ms, %d threads\n", VEHICLE_PERIOD,
+         CONTROL_PERIOD, tune_jobs);
+  printf("score = settling + %g * overshoot + %g * effort\n\n",
+         tune_w_overshoot, tune_w_effort);
+
+  /* Logarithmic grid */
+  n = points * points * points;
+  grid = malloc(n * sizeof(*grid));
+  if (grid == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  for (i = 0; i < n; i++)
+    for (a = 0, j = i; a < 3; a++, j /= points)
+      grid[i].k[a] = tune_min[a] * pow(tune_max[a] / tune_min[a],
+                                       (double) (j % points) / (points - 1));
+  t0 = tune_now();
+  tune_eval(&current);
+  tune_eval_batch(grid, n);
+  qsort(grid, n, sizeof(*grid), tune_by_score);
+  grid_best = grid[0];
+  t_grid = tune_now();
+
+  /* Refine the best grid points; the first step is half the grid spacing */
+  step = log(tune_max[0] / tune_min[0]) / (points - 1) / 2;
+  tune_refine(grid, n < TUNE_STARTS ? n : TUNE_STARTS, step);
+  qsort(grid, n < TUNE_STARTS ? n : TUNE_STARTS, sizeof(*grid),
+        tune_by_score);
+  t_end = tune_now();
+
+  printf("%-10s %8s %7s %7s %9s %9s %7s %8s\n", "", tune_axis[0],
+         tune_axis[1], tune_axis[2], "settle_s", "over_m/s", "effort", "score");
+  tune_print("current", &current);
+  tune_print("grid", &grid_best);
+  for (i = 0; i < TUNE_STARTS && i < n; i++)
+    tune_print(i == 0 ? "best" : "", &grid[i]);
+  printf("\n%lu evaluations in %.2f s (grid %.2f s), %.0f per second\n",
+         (unsigned long) tune_evals + 1, t_end - t0, t_grid - t0,
+         (tune_evals + 1) / (t_end - t0));
+  printf("-DPID_KP=%.4g -DPID_KI=%.4g -DPID_KD=%.4g\n", grid[0].k[0],
+         grid[0].k[1], grid[0].k[2]);
+  free(grid);
+  return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * uC/OS-II API for the host (Linux) build.
+ *
+ * Only the services used by the lab applications are provided.  Names,
+ * argument lists, option bits and error codes follow uC/OS-II V2.86 as
+ * shipped with the Nios II BSP.
+ */
+#ifndef __UCOS_II_H__
+#define __UCOS_II_H__
+
+#include "os_cpu.h"
+#include "os_cfg.h"
+
+#define OS_VERSION            286
+
+#ifndef  FALSE
+#define  FALSE                  0
+#endif
+#ifndef  TRUE
+#define  TRUE                   1
+#endif
+
+#define OS_PRIO_SELF         0xFF
+#define OS_TASK_IDLE_PRIO    (OS_LOWEST_PRIO)
+#define OS_TASK_STAT_PRIO    (OS_LOWEST_PRIO - 1)
+
+/*
+ * Task status (OSTCBStat)
+ */
+#define OS_STAT_RDY          0x00
+#define OS_STAT_SEM          0x01
+#define OS_STAT_MBOX         0x02
+#define OS_STAT_Q            0x04
+#define OS_STAT_SUSPEND      0x08
+#define OS_STAT_MUTEX        0x10
+#define OS_STAT_FLAG         0x20
+#define OS_STAT_PEND_ANY     (OS_STAT_SEM | OS_STAT_MBOX | OS_STAT_Q | \
+                              OS_STAT_MUTEX | OS_STAT_FLAG)
+
+/*
+ * Event types
+ */
+#define OS_EVENT_TYPE_UNUSED    0
+#define OS_EVENT_TYPE_MBOX      1
+#define OS_EVENT_TYPE_Q         2
+#define OS_EVENT_TYPE_SEM       3
+#define OS_EVENT_TYPE_MUTEX     4
+#define OS_EVENT_TYPE_FLAG      5
+
+/*
+ * Event flag options
+ */
+#define OS_FLAG_WAIT_CLR_ALL    0
+#define OS_FLAG_WAIT_CLR_AND    0
+#define OS_FLAG_WAIT_CLR_ANY    1
+#define OS_FLAG_WAIT_CLR_OR     1
+#define OS_FLAG_WAIT_SET_ALL    2
+#define OS_FLAG_WAIT_SET_AND    2
+#define OS_FLAG_WAIT_SET_ANY    3
+#define OS_FLAG_WAIT_SET_OR     3
+#define OS_FLAG_CONSUME      0x80
+
+#define OS_FLAG_CLR             0
+#define OS_FLAG_SET             1
+
+/*
+ * Task options (OSTaskCreateExt())
+ */
+#define OS_TASK_OPT_NONE     0x0000
+#define OS_TASK_OPT_STK_CHK  0x0001
+#define OS_TASK_OPT_STK_CLR  0x0002
+#define OS_TASK_OPT_SAVE_FP  0x0004
+
+/* OSTCBPrioTbl[] entry of a priority reserved for a task being created */
+#define OS_TCB_RESERVED      ((OS_TCB *) 1)
+
+/*
+ * Timer options and states
+ */
+#define OS_TMR_OPT_NONE         0
+#define OS_TMR_OPT_ONE_SHOT     1
+#define OS_TMR_OPT_PERIODIC     2
+#define OS_TMR_OPT_CALLBACK     3
+#define OS_TMR_OPT_CALLBACK_ARG 4
+
+#define OS_TMR_STATE_UNUSED     0
+#define OS_TMR_STATE_STOPPED    1
+#define OS_TMR_STATE_COMPLETED  2
+#define OS_TMR_STATE_RUNNING    3
+
+/*
+ * Error codes
+ */
+#define OS_ERR_NONE                   0
+#define OS_ERR_EVENT_TYPE             1
+#define OS_ERR_PEND_ISR               2
+#define OS_ERR_POST_NULL_PTR          3
+#define OS_ERR_PEVENT_NULL            4
+#define OS_ERR_PDATA_NULL             9
+#define OS_ERR_TIMEOUT               10
+#define OS_ERR_PEND_LOCKED           13
+#define OS_ERR_CREATE_ISR            16
+#define OS_ERR_MBOX_FULL             20
+#define OS_ERR_TIME_INVALID_MINUTES  81
+#define OS_ERR_TIME_INVALID_SECONDS  82
+#define OS_ERR_TIME_INVALID_MS       83
+#define OS_ERR_TIME_ZERO_DLY         84
+#define OS_ERR_TIME_DLY_ISR          85
+#define OS_ERR_TASK_CREATE_ISR       60
+#define OS_ERR_TASK_DEL_IDLE         62
+#define OS_ERR_TASK_DEL_ISR          64
+#define OS_ERR_TASK_NO_MORE_TCB      66
+#define OS_ERR_TASK_NOT_EXIST        67
+#define OS_ERR_TASK_OPT              69
+#define OS_ERR_PRIO_EXIST            40
+#define OS_ERR_PRIO_INVALID          42
+#define OS_ERR_SEM_OVF               50
+#define OS_ERR_TMR_INVALID_DLY      130
+#define OS_ERR_TMR_INVALID_PERIOD   131
+#define OS_ERR_TMR_INVALID_OPT      132
+#define OS_ERR_TMR_INVALID          138
+#define OS_ERR_TMR_INACTIVE         140
+#define OS_ERR_TMR_INVALID_TYPE     141
+#define OS_ERR_TMR_ISR              143
+#define OS_ERR_TMR_NON_AVAIL        144
+#define OS_ERR_TMR_STOPPED          146
+#define OS_ERR_FLAG_INVALID_PGRP    150
+#define OS_ERR_FLAG_WAIT_TYPE       151
+#define OS_ERR_FLAG_NOT_RDY         152
+#define OS_ERR_FLAG_INVALID_OPT     153
+#define OS_ERR_FLAG_GRP_DEPLETED    154
+
+/* Names of the error codes before V2.84, still used by application code */
+#define OS_NO_ERR                   OS_ERR_NONE
+#define OS_TIMEOUT                  OS_ERR_TIMEOUT
+#define OS_MBOX_FULL                OS_ERR_MBOX_FULL
+#define OS_SEM_OVF                  OS_ERR_SEM_OVF
+#define OS_TASK_NOT_EXIST           OS_ERR_TASK_NOT_EXIST
+#define OS_FLAG_ERR_NOT_RDY         OS_ERR_FLAG_NOT_RDY
+
+/*
+ * Kernel objects
+ */
+typedef INT16U OS_FLAGS;
+
+typedef struct os_event {
+    INT8U    OSEventType;
+    void    *OSEventPtr;             /* Message of a mailbox               */
+    INT16U   OSEventCnt;             /* Count of a semaphore               */
+} OS_EVENT;
+
+typedef struct os_flag_grp {
+    INT8U    OSFlagType;
+    OS_FLAGS OSFlagFlags;
+} OS_FLAG_GRP;
+
+typedef void (*OS_TMR_CALLBACK)(void *ptmr, void *parg);
+
+typedef struct os_tmr {
+    INT8U           OSTmrType;
+    OS_TMR_CALLBACK OSTmrCallback;
+    void           *OSTmrCallbackArg;
+    INT32U          OSTmrMatch;      /* Timer expires when OSTmrTime matches */
+    INT32U          OSTmrDly;
+    INT32U          OSTmrPeriod;
+    INT8U          *OSTmrName;
+    INT8U           OSTmrOpt;
+    INT8U           OSTmrState;
+} OS_TMR;
+
+typedef struct os_stk_data {
+    INT32U  OSFree;                  /* Number of free bytes on the stack  */
+    INT32U  OSUsed;                  /* Number of bytes used on the stack  */
+} OS_STK_DATA;
+
+typedef struct os_tcb {
+    OS_STK  *OSTCBStkPtr;
+    void    *OSTCBExtPtr;
+    OS_STK  *OSTCBStkBottom;
+    INT32U   OSTCBStkSize;
+    INT16U   OSTCBOpt;
+    INT16U   OSTCBId;
+
+    void    *OSTCBEventPtr;          /* OS_EVENT or OS_FLAG_GRP pended on  */
+    void    *OSTCBMsg;
+    OS_FLAGS OSTCBFlagsWait;
+    INT8U    OSTCBFlagWaitType;
+    OS_FLAGS OSTCBFlagsRdy;
+
+    INT32U   OSTCBDly;
+    INT8U    OSTCBStat;
+    BOOLEAN  OSTCBPendTO;
+    INT8U    OSTCBPrio;
+    INT32U   OSTCBCtxSwCtr;
+
+    void    *OSTCBHost;              /* Host thread backing this task      */
+} OS_TCB;
+
+/*
+ * Global variables
+ */
+extern INT8U   OSCPUUsage;
+extern INT32U  OSIdleCtr;
+extern INT32U  OSIdleCtrMax;
+extern INT32U  OSCtxSwCtr;
+extern INT8U   OSIntNesting;
+extern INT8U   OSLockNesting;
+extern BOOLEAN OSRunning;
+extern INT32U  OSTime;
+extern INT32U  OSTmrTime;
+extern OS_TCB *OSTCBCur;
+extern OS_TCB *OSTCBHighRdy;
+extern OS_TCB *OSTCBPrioTbl[OS_LOWEST_PRIO + 1];
+
+/*
+ * Application hooks, called by the port with OS_APP_HOOKS_EN: the switch
+ * hook runs with OSTCBCur still the old task and OSTCBHighRdy the new one,
+ * the tick hook at the start of OSTimeTick(), the idle hook on every pass
+ * of the idle loop
+ */
+#if OS_APP_HOOKS_EN > 0
+void      App_TaskCreateHook(OS_TCB *ptcb);
+void      App_TaskDelHook(OS_TCB *ptcb);
+void      App_TaskIdleHook(void);
+void      App_TaskStatHook(void);
+void      App_TaskSwHook(void);
+void      App_TCBInitHook(OS_TCB *ptcb);
+void      App_TimeTickHook(void);
+#endif
+
+/*
+ * Kernel
+ */
+void      OSInit(void);
+void      OSStart(void);
+void      OSStatInit(void);
+void      OSIntEnter(void);
+void      OSIntExit(void);
+void      OSSchedLock(void);
+void      OSSchedUnlock(void);
+INT16U    OSVersion(void);
+
+/*
+ * Tasks
+ */
+INT8U     OSTaskCreate(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos,
+                       INT8U prio);
+INT8U     OSTaskCreateExt(void (*task)(void *p_arg), void *p_arg,
+                          OS_STK *ptos, INT8U prio, INT16U id,
+                          OS_STK *pbos, INT32U stk_size, void *pext,
+                          INT16U opt);
+INT8U     OSTaskDel(INT8U prio);
+INT8U     OSTaskStkChk(INT8U prio, OS_STK_DATA *p_stk_data);
+
+/*
+ * Time
+ */
+void      OSTimeDly(INT16U ticks);
+INT8U     OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds,
+                        INT16U ms);
+INT32U    OSTimeGet(void);
+void      OSTimeTick(void);
+
+/*
+ * Semaphores
+ */
+OS_EVENT *OSSemCreate(INT16U cnt);
+void      OSSemPend(OS_EVENT *pevent, INT16U timeout, INT8U *perr);
+INT8U     OSSemPost(OS_EVENT *pevent);
+INT16U    OSSemAccept(OS_EVENT *pevent);
+
+/*
+ * Mailboxes
+ */
+OS_EVENT *OSMboxCreate(void *pmsg);
+void     *OSMboxPend(OS_EVENT *pevent, INT16U timeout, INT8U *perr);
+INT8U     OSMboxPost(OS_EVENT *pevent, void *pmsg);
+void     *OSMboxAccept(OS_EVENT *pevent);
+
+/*
+ * Event flags
+ */
+OS_FLAG_GRP *OSFlagCreate(OS_FLAGS flags, INT8U *perr);
+OS_FLAGS  OSFlagPend(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U wait_type,
+                     INT16U timeout, INT8U *perr);
+OS_FLAGS  OSFlagPost(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U opt,
+                     INT8U *perr);
+OS_FLAGS  OSFlagAccept(OS_FLAG_GRP *pgrp, OS_FLAGS flags, INT8U wait_type,
+                       INT8U *perr);
+OS_FLAGS  OSFlagQuery(OS_FLAG_GRP *pgrp, INT8U *perr);
+
+/*
+ * Software timers
+ */
+OS_TMR   *OSTmrCreate(INT32U dly, INT32U period, INT8U opt,
+                      OS_TMR_CALLBACK callback, void *callback_arg,
+                      INT8U *pname, INT8U *perr);
+BOOLEAN   OSTmrStart(OS_TMR *ptmr, INT8U *perr);
+BOOLEAN   OSTmrStop(OS_TMR *ptmr, INT8U opt, void *callback_arg,
+                    INT8U *perr);
+INT8U     OSTmrSignal(void);
+
+#endif /* __UCOS_II_H__ */
@@ -0,0 +1,473 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "vehicle_batch.h"
+#include "track.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VEHICLE_BATCH_X86 1
+#include <immintrin.h>
+#else
+#define VEHICLE_BATCH_X86 0
+#endif
+
+#define BATCH_BRAKE 200         /* 0.1 m/s^2, as in vehicle_plant_step() */
+
+int vehicle_batch_track_init(struct vehicle_batch_track *t,
+                             const INT8S *slope,
+                             const struct vehicle_drag *drag)
+{
+  INT32S n;
+  INT16U i;
+
+  if (track_segments > VEHICLE_BATCH_SEGMENTS_MAX)
+    return -1;
+  memset(t, 0, sizeof(*t));
+  for (i = 0; i < track_segments; i++) {
+    t->start[i] = (INT32S) track[i].start;
+    t->slope[i] = slope != NULL ? slope[i] : track[i].slope;
+  }
+  /* Halves of the search: the last start at or below the position */
+  for (n = track_segments; n > 1; n -= n / 2)
+    t->half[t->steps++] = n / 2;
+  t->length = (INT32S) track_length;
+  t->drag   = *drag;
+  return 0;
+}
+
+int vehicle_batch_alloc(struct vehicle_batch *b, INT32U num)
+{
+  /* Rounded up to whole vectors, so the arrays can be read in full */
+  size_t n = ((size_t) num + 15) & ~(size_t) 15;
+  void **array[7] = { (void **) &b->position, (void **) &b->velocity,
+                      (void **) &b->position_frac, (void **) &b->velocity_frac,
+                      (void **) &b->segment, (void **) &b->throttle,
+                      (void **) &b->brake };
+  size_t size[7] = { 4, 2, 2, 2, 2, 1, 1 };
+  int i;
+
+  memset(b, 0, sizeof(*b));
+  b->num = num;
+  for (i = 0; i < 7; i++) {
+    *array[i] = aligned_alloc(VEHICLE_BATCH_ALIGN, n * size[i]);
+    if (*array[i] == NULL) {
+      vehicle_batch_free(b);
+      return -1;
+    }
+    memset(*array[i], 0, n * size[i]);
+  }
+  return 0;
+}
+
+void vehicle_batch_free(struct vehicle_batch *b)
+{
+  free(b->position);
+  free(b->velocity);
+  free(b->position_frac);
+  free(b->velocity_frac);
+  free(b->segment);
+  free(b->throttle);
+  free(b->brake);
+  memset(b, 0, sizeof(*b));
+}
+
+static inline INT32S batch_find(const struct vehicle_batch_track *t,
+                                INT32S position)
+{
+  INT32S base = 0, s;
+
+  for (s = 0; s < t->steps; s++)
+    base = t->start[base + t->half[s]] <= position ? base + t->half[s] : base;
+  return base;
+}
+
+void vehicle_batch_locate(struct vehicle_batch *b,
+                          const struct vehicle_batch_track *t)
+{
+  INT32U i;
+
+  for (i = 0; i < b->num; i++)
+    b->segment[i] = (INT16U) batch_find(t, (INT32S) b->position[i]);
+}
+
+/*
+ * Scalar kernel, also for the vehicles after the last full vector
+ */
+static void batch_scalar(struct vehicle_batch *b,
+                         const struct vehicle_batch_track *t, INT32S dt,
+                         INT32U from, INT32U to)
+{
+  INT32S rolling = t->drag.rolling, wind_div = t->drag.wind_div;
+  INT32S v, vf, q, a, x, position, old, velocity, dv;
+  INT32U i;
+
+  for (i = from; i < to; i++) {
+    v  = b->velocity[i];
+    vf = b->velocity_frac[i];
+
+    /* vehicle_acceleration_drag() */
+    q = v * v / wind_div;
+    q = (INT16S) ((v > 0 ? q : -q) + rolling);
+    a = (INT16S) ((b->throttle[i] >> 1) - (q + t->slope[b->segment[i]]));
+    a = v == 0 && vf == 0 && a >= -rolling && a <= rolling ? 0 : a;
+    a = (INT8S) a;
+
+    /* vehicle_plant_step() */
+    old = v * 1000 + vf;
+    velocity = b->brake[i] == 0 ? old + a * dt :
+               BATCH_BRAKE * dt > old ? 0 : old - BATCH_BRAKE * dt;
+    velocity = (old > 0 && velocity < 0) || (old < 0 && velocity > 0) ?
+               0 : velocity;
+    b->velocity[i] = (INT16S) (velocity / 1000);
+    b->velocity_frac[i] = (INT16S) (velocity % 1000);
+
+    dv = velocity - old;
+    x = b->position_frac[i] + v * dt + vf * dt / 1000 +
+        dv / 2000 * dt + dv % 2000 * dt / 2000;
+    position = (INT32S) b->position[i] + x / 1000;
+    position = position > t->length ? position - t->length :
+               position < 0 ? position + t->length : position;
+    b->position[i] = (INT32U) position;
+    b->position_frac[i] = (INT16S) (x % 1000);
+
+    b->segment[i] = (INT16U) batch_find(t, position);
+  }
+}
+
+#if VEHICLE_BATCH_X86
+
+/*
+ * SSE4.1 kernel, 4 vehicles per iteration
+ */
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+
+/* x / d truncated toward zero, exact in double for 32-bit x */
+static inline __m128i batch_div_sse(__m128i x, __m128d d)
+{
+  __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(x), d));
+  __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(
+                 _mm_cvtepi32_pd(_mm_unpackhi_epi64(x, x)), d));
+
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+/* x * m / d truncated toward zero, exact while |x * m| < 2^53 */
+static inline __m128i batch_muldiv_sse(__m128i x, __m128d m, __m128d d)
+{
+  __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(
+                 _mm_mul_pd(_mm_cvtepi32_pd(x), m), d));
+  __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(
+                 _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(x, x)), m), d));
+
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+/* The cast to INT16S of each lane */
+static inline __m128i batch_int16_sse(__m128i x)
+{
+  return _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+}
+
+static inline __m128i batch_gather_sse(const INT32S *table, __m128i i)
+{
+  return _mm_set_epi32(table[_mm_extract_epi32(i, 3)],
+                       table[_mm_extract_epi32(i, 2)],
+                       table[_mm_extract_epi32(i, 1)],
+                       table[_mm_extract_epi32(i, 0)]);
+}
+
+/* Low 16 bits of each lane, as the cast to INT16S or INT16U */
+static inline void batch_store16_sse(void *p, __m128i x)
+{
+  const __m128i low = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                    -1, -1, -1, -1, -1, -1, -1, -1);
+
+  _mm_storel_epi64((__m128i *) p, _mm_shuffle_epi8(x, low));
+}
+
+static inline __m128i batch_load8_sse(const INT8U *p)
+{
+  INT32S x;
+
+  memcpy(&x, p, sizeof(x));
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(x));
+}
+
+static void batch_sse41(struct vehicle_batch *b,
+                        const struct vehicle_batch_track *t, INT32S dt,
+                        INT32U to)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rolling = _mm_set1_epi32(t->drag.rolling);
+  const __m128i rolling_neg = _mm_set1_epi32(-t->drag.rolling);
+  const __m128i length = _mm_set1_epi32(t->length);
+  const __m128i vdt = _mm_set1_epi32(dt);
+  const __m128i k1000 = _mm_set1_epi32(1000);
+  const __m128i brake_dv = _mm_set1_epi32(BATCH_BRAKE * dt);
+  const __m128d wind_div = _mm_set1_pd(t->drag.wind_div);
+  const __m128d d1000 = _mm_set1_pd(1000);
+  const __m128d d2000 = _mm_set1_pd(2000);
+  const __m128d ddt = _mm_set1_pd(dt);
+  __m128i v, vf, seg, q, a, x, w, position, gt, lt, old, velocity, braked;
+  __m128i mask, base, cand;
+  INT32U i;
+  INT32S s;
+
+  for (i = 0; i < to; i += 4) {
+    v   = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *) &b->velocity[i]));
+    vf  = _mm_cvtepi16_epi32(
+            _mm_loadl_epi64((const __m128i *) &b->velocity_frac[i]));
+    seg = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) &b->segment[i]));
+
+    /* vehicle_acceleration_drag() */
+    q = batch_div_sse(_mm_mullo_epi32(v, v), wind_div);
+    q = _mm_blendv_epi8(_mm_sub_epi32(zero, q), q, _mm_cmpgt_epi32(v, zero));
+    q = batch_int16_sse(_mm_add_epi32(q, rolling));
+    a = _mm_sub_epi32(_mm_srli_epi32(batch_load8_sse(&b->throttle[i]), 1),
+                      _mm_add_epi32(q, batch_gather_sse(t->slope, seg)));
+    a = batch_int16_sse(a);
+    mask = _mm_and_si128(_mm_cmpeq_epi32(v, zero), _mm_cmpeq_epi32(vf, zero));
+    mask = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(rolling_neg, a),
+                                         _mm_cmpgt_epi32(a, rolling)), mask);
+    a = _mm_andnot_si128(mask, a);
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 24), 24);
+
+    /* vehicle_plant_step() */
+    old = _mm_add_epi32(_mm_mullo_epi32(v, k1000), vf);
+    braked = _mm_andnot_si128(_mm_cmpgt_epi32(brake_dv, old),
+                              _mm_sub_epi32(old, brake_dv));
+    velocity = _mm_blendv_epi8(_mm_add_epi32(old, _mm_mullo_epi32(a, vdt)),
+                               braked,
+                               _mm_xor_si128(_mm_cmpeq_epi32(
+                                 batch_load8_sse(&b->brake[i]), zero),
+                                 _mm_cmpeq_epi32(zero, zero)));
+    mask = _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi32(old, zero),
+                                      _mm_cmpgt_epi32(zero, velocity)),
+                        _mm_and_si128(_mm_cmpgt_epi32(zero, old),
+                                      _mm_cmpgt_epi32(velocity, zero)));
+    velocity = _mm_andnot_si128(mask, velocity);
+    w = batch_div_sse(velocity, d1000);
+    batch_store16_sse(&b->velocity[i], w);
+    batch_store16_sse(&b->velocity_frac[i],
+                      _mm_sub_epi32(velocity, _mm_mullo_epi32(w, k1000)));
+
+    x = _mm_add_epi32(_mm_cvtepi16_epi32(
+                        _mm_loadl_epi64((const __m128i *) &b->position_frac[i])),
+                      _mm_mullo_epi32(v, vdt));
+    x = _mm_add_epi32(x, batch_div_sse(_mm_mullo_epi32(vf, vdt), d1000));
+    x = _mm_add_epi32(x, batch_muldiv_sse(_mm_sub_epi32(velocity, old), ddt,
+                                          d2000));
+    w = batch_div_sse(x, d1000);
+    position = _mm_add_epi32(_mm_loadu_si128((const __m128i *) &b->position[i]),
+                             w);
+    gt = _mm_cmpgt_epi32(position, length);
+    lt = _mm_cmpgt_epi32(zero, position);
+    position = _mm_blendv_epi8(position, _mm_sub_epi32(position, length), gt);
+    position = _mm_blendv_epi8(position, _mm_add_epi32(position, length), lt);
+    _mm_storeu_si128((__m128i *) &b->position[i], position);
+    batch_store16_sse(&b->position_frac[i],
+                      _mm_sub_epi32(x, _mm_mullo_epi32(w, k1000)));
+
+    /* Segment search */
+    base = zero;
+    for (s = 0; s < t->steps; s++) {
+      cand = _mm_add_epi32(base, _mm_set1_epi32(t->half[s]));
+      base = _mm_blendv_epi8(cand, base,
+                             _mm_cmpgt_epi32(batch_gather_sse(t->start, cand),
+                                             position));
+    }
+    batch_store16_sse(&b->segment[i], base);
+  }
+}
+
+#pragma GCC pop_options
+
+/*
+ * AVX2 kernel, 8 vehicles per iteration
+ */
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+static inline __m256i batch_div_avx2(__m256i x, __m256d d)
+{
+  __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(
+                 _mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), d));
+  __m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(
+                 _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), d));
+
+  return _mm256_set_m128i(hi, lo);
+}
+
+static inline __m256i batch_muldiv_avx2(__m256i x, __m256d m, __m256d d)
+{
+  __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_mul_pd(
+                 _mm256_cvtepi32_pd(_mm256_castsi256_si128(x)), m), d));
+  __m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_mul_pd(
+                 _mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)), m), d));
+
+  return _mm256_set_m128i(hi, lo);
+}
+
+static inline __m256i batch_int16_avx2(__m256i x)
+{
+  return _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+}
+
+static inline void batch_store16_avx2(void *p, __m256i x)
+{
+  const __m256i low = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                       -1, -1, -1, -1, -1, -1, -1, -1,
+                                       0, 1, 4, 5, 8, 9, 12, 13,
+                                       -1, -1, -1, -1, -1, -1, -1, -1);
+
+  x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, low), 0x08);
+  _mm_storeu_si128((__m128i *) p, _mm256_castsi256_si128(x));
+}
+
+static inline __m256i batch_load8_avx2(const INT8U *p)
+{
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p));
+}
+
+static inline __m256i batch_load16_avx2(const INT16S *p)
+{
+  return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+
+static void batch_avx2(struct vehicle_batch *b,
+                       const struct vehicle_batch_track *t, INT32S dt,
+                       INT32U to)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_cmpeq_epi32(zero, zero);
+  const __m256i rolling = _mm256_set1_epi32(t->drag.rolling);
+  const __m256i rolling_neg = _mm256_set1_epi32(-t->drag.rolling);
+  const __m256i length = _mm256_set1_epi32(t->length);
+  const __m256i vdt = _mm256_set1_epi32(dt);
+  const __m256i k1000 = _mm256_set1_epi32(1000);
+  const __m256i brake_dv = _mm256_set1_epi32(BATCH_BRAKE * dt);
+  const __m256d wind_div = _mm256_set1_pd(t->drag.wind_div);
+  const __m256d d1000 = _mm256_set1_pd(1000);
+  const __m256d d2000 = _mm256_set1_pd(2000);
+  const __m256d ddt = _mm256_set1_pd(dt);
+  __m256i v, vf, seg, q, a, x, w, position, gt, lt, old, velocity, braked;
+  __m256i mask, base, cand;
+  INT32U i;
+  INT32S s;
+
+  for (i = 0; i < to; i += 8) {
+    v   = batch_load16_avx2(&b->velocity[i]);
+    vf  = batch_load16_avx2(&b->velocity_frac[i]);
+    seg = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) &b->segment[i]));
+
+    /* vehicle_acceleration_drag() */
+    q = batch_div_avx2(_mm256_mullo_epi32(v, v), wind_div);
+    q = _mm256_blendv_epi8(_mm256_sub_epi32(zero, q), q,
+                           _mm256_cmpgt_epi32(v, zero));
+    q = batch_int16_avx2(_mm256_add_epi32(q, rolling));
+    a = _mm256_sub_epi32(
+          _mm256_srli_epi32(batch_load8_avx2(&b->throttle[i]), 1),
+          _mm256_add_epi32(q, _mm256_i32gather_epi32((const int *) t->slope,
+                                                     seg, 4)));
+    a = batch_int16_avx2(a);
+    mask = _mm256_and_si256(_mm256_cmpeq_epi32(v, zero),
+                            _mm256_cmpeq_epi32(vf, zero));
+    mask = _mm256_andnot_si256(_mm256_or_si256(
+                                 _mm256_cmpgt_epi32(rolling_neg, a),
+                                 _mm256_cmpgt_epi32(a, rolling)), mask);
+    a = _mm256_andnot_si256(mask, a);
+    a = _mm256_srai_epi32(_mm256_slli_epi32(a, 24), 24);
+
+    /* vehicle_plant_step() */
+    old = _mm256_add_epi32(_mm256_mullo_epi32(v, k1000), vf);
+    braked = _mm256_andnot_si256(_mm256_cmpgt_epi32(brake_dv, old),
+                                 _mm256_sub_epi32(old, brake_dv));
+    velocity = _mm256_blendv_epi8(
+                 _mm256_add_epi32(old, _mm256_mullo_epi32(a, vdt)), braked,
+                 _mm256_xor_si256(_mm256_cmpeq_epi32(
+                   batch_load8_avx2(&b->brake[i]), zero), ones));
+    mask = _mm256_or_si256(_mm256_and_si256(_mm256_cmpgt_epi32(old, zero),
+                                            _mm256_cmpgt_epi32(zero, velocity)),
+                           _mm256_and_si256(_mm256_cmpgt_epi32(zero, old),
+                                            _mm256_cmpgt_epi32(velocity, zero)));
+    velocity = _mm256_andnot_si256(mask, velocity);
+    w = batch_div_avx2(velocity, d1000);
+    batch_store16_avx2(&b->velocity[i], w);
+    batch_store16_avx2(&b->velocity_frac[i],
+                       _mm256_sub_epi32(velocity, _mm256_mullo_epi32(w, k1000)));
+
+    x = _mm256_add_epi32(batch_load16_avx2(&b->position_frac[i]),
+                         _mm256_mullo_epi32(v, vdt));
+    x = _mm256_add_epi32(x, batch_div_avx2(_mm256_mullo_epi32(vf, vdt), d1000));
+    x = _mm256_add_epi32(x, batch_muldiv_avx2(_mm256_sub_epi32(velocity, old),
+                                              ddt, d2000));
+    w = batch_div_avx2(x, d1000);
+    position = _mm256_add_epi32(
+                 _mm256_loadu_si256((const __m256i *) &b->position[i]), w);
+    gt = _mm256_cmpgt_epi32(position, length);
+    lt = _mm256_cmpgt_epi32(zero, position);
+    position = _mm256_blendv_epi8(position,
+                                  _mm256_sub_epi32(position, length), gt);
+    position = _mm256_blendv_epi8(position,
+                                  _mm256_add_epi32(position, length), lt);
+    _mm256_storeu_si256((__m256i *) &b->position[i], position);
+    batch_store16_avx2(&b->position_frac[i],
+                       _mm256_sub_epi32(x, _mm256_mullo_epi32(w, k1000)));
+
+    /* Segment search */
+    base = zero;
+    for (s = 0; s < t->steps; s++) {
+      cand = _mm256_add_epi32(base, _mm256_set1_epi32(t->half[s]));
+      base = _mm256_blendv_epi8(cand, base, _mm256_cmpgt_epi32(
+               _mm256_i32gather_epi32((const int *) t->start, cand, 4),
+               position));
+    }
+    batch_store16_avx2(&b->segment[i], base);
+  }
+}
+
+#pragma GCC pop_options
+
+#endif /* VEHICLE_BATCH_X86 */
+
+enum vehicle_batch_kernel vehicle_batch_best(void)
+{
+#if VEHICLE_BATCH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return VEHICLE_BATCH_AVX2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return VEHICLE_BATCH_SSE41;
+#endif
+  return VEHICLE_BATCH_SCALAR;
+}
+
+const char *vehicle_batch_name(enum vehicle_batch_kernel k)
+{
+  static const char *name[] = { "scalar", "sse41", "avx2", "best" };
+
+  return k <= VEHICLE_BATCH_BEST ? name[k] : "?";
+}
+
+enum vehicle_batch_kernel
+vehicle_batch_step(struct vehicle_batch *b, const struct vehicle_batch_track *t,
+                   INT16U interval, enum vehicle_batch_kernel k)
+{
+  enum vehicle_batch_kernel best = vehicle_batch_best();
+  INT32U vectors = 0;
+
+  if (k == VEHICLE_BATCH_BEST || k > best)
+    k = best;
+#if VEHICLE_BATCH_X86
+  if (k == VEHICLE_BATCH_AVX2) {
+    vectors = b->num & ~7u;
+    batch_avx2(b, t, interval, vectors);
+  } else if (k == VEHICLE_BATCH_SSE41) {
+    vectors = b->num & ~3u;
+    batch_sse41(b, t, interval, vectors);
+  }
+#endif
+  batch_scalar(b, t, interval, vectors, b->num);
+  return k;
+}
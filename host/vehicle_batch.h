@@ -0,0 +1,91 @@
+/*
+ * Batch stepping of many vehicles (host only)
+ *
+ * The vehicles are stored as a structure of arrays, one array per field
+ * of struct vehicle_plant plus the segment, the throttle and the brake.
+ * vehicle_batch_step() advances all of them by one interval, as
+ * VehicleTask does for one: vehicle_acceleration_drag() on the slope of
+ * the segment, vehicle_plant_step(), then the segment at the new
+ * position.  The results are bit-identical to those functions, for every
+ * kernel:
+ *
+ *   scalar  plain C, no branches in the loop but the loop itself
+ *   sse41   4 vehicles per iteration (SSE4.1)
+ *   avx2    8 vehicles per iteration (AVX2), the slopes and segment
+ *           starts loaded with gathers
+ *
+ * The divisions by 1000 and by the wind divisor are done in double,
+ * which is exact for the 32-bit operands.  The segment lookup is a
+ * binary search with a fixed number of steps for the track (log2 of the
+ * segments), with selects instead of branches.  The SIMD kernels are
+ * compiled for their instruction set whatever the flags of the build,
+ * and VEHICLE_BATCH_BEST picks the best one the CPU supports; the
+ * vehicles beyond the last full vector take the scalar kernel.
+ */
+#ifndef VEHICLE_BATCH_H_
+#define VEHICLE_BATCH_H_
+
+#include "includes.h"
+#include "vehicle.h"
+
+#define VEHICLE_BATCH_SEGMENTS_MAX 1024
+#define VEHICLE_BATCH_ALIGN        32   /* Bytes, of each array */
+
+enum vehicle_batch_kernel {
+  VEHICLE_BATCH_SCALAR,
+  VEHICLE_BATCH_SSE41,
+  VEHICLE_BATCH_AVX2,
+  VEHICLE_BATCH_BEST
+};
+
+/* Track and drag shared by the vehicles of a batch */
+struct vehicle_batch_track {
+  INT32S start[VEHICLE_BATCH_SEGMENTS_MAX];     /* 0.1 m */
+  INT32S slope[VEHICLE_BATCH_SEGMENTS_MAX];     /* 0.1 m/s^2 */
+  INT32S half[16];      /* Steps of the segment search */
+  INT32S steps;
+  INT32S length;        /* 0.1 m */
+  struct vehicle_drag drag;
+};
+
+struct vehicle_batch {
+  INT32U  num;
+  INT32U *position;     /* 0.1 m */
+  INT16S *velocity;     /* 0.1 m/s */
+  INT16S *position_frac;
+  INT16S *velocity_frac;
+  INT16U *segment;
+  INT8U  *throttle;     /* 0.1 V, input */
+  INT8U  *brake;        /* Input, nonzero: pressed */
+};
+
+/*
+ * The track of TRACK_TABLE with the slopes of 'slope' (NULL: those of the
+ * table); returns -1 if it has more than VEHICLE_BATCH_SEGMENTS_MAX
+ * segments
+ */
+int  vehicle_batch_track_init(struct vehicle_batch_track *t,
+                              const INT8S *slope,
+                              const struct vehicle_drag *drag);
+
+/* Arrays of 'num' vehicles, zeroed; returns -1 if out of memory */
+int  vehicle_batch_alloc(struct vehicle_batch *b, INT32U num);
+void vehicle_batch_free(struct vehicle_batch *b);
+
+/* Segments of the positions, after the positions were set */
+void vehicle_batch_locate(struct vehicle_batch *b,
+                          const struct vehicle_batch_track *t);
+
+/* Kernel that VEHICLE_BATCH_BEST selects, and the name of a kernel */
+enum vehicle_batch_kernel vehicle_batch_best(void);
+const char *vehicle_batch_name(enum vehicle_batch_kernel k);
+
+/*
+ * Advances all vehicles by 'interval' ms [at most 60000]; returns the
+ * kernel used, which is the scalar one for a kernel the CPU lacks
+ */
+enum vehicle_batch_kernel
+vehicle_batch_step(struct vehicle_batch *b, const struct vehicle_batch_track *t,
+                   INT16U interval, enum vehicle_batch_kernel k);
+
+#endif /* VEHICLE_BATCH_H_ */
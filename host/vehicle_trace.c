@@ -0,0 +1,46 @@
+/*
+ * Sample of the host trace (CRUISE_HOST_TRACE), linked into cruise_host
+ * only: the application stays as on the board, and alt_host.c does not
+ * know the vehicle state.
+ */
+#include "includes.h"
+#include "vehicle_state.h"
+#include "alt_host.h"
+
+/*
+ * Record after each update of VehicleTask: 32 bit number of the update,
+ * 32 bit position, 16 bit velocity, 8 bit throttle and 8 bit 0, little
+ * endian
+ */
+static void vehicle_trace_sample(void *buf, size_t *len)
+{
+  static INT32U last_seq;
+  struct vehicle_state state;
+  INT8U *b = buf;
+
+  vehicle_state_read(&state);
+  if (state.seq == last_seq || *len < 12) {
+    *len = 0;
+    return;
+  }
+  last_seq = state.seq;
+  b[0]  = state.seq;
+  b[1]  = state.seq >> 8;
+  b[2]  = state.seq >> 16;
+  b[3]  = state.seq >> 24;
+  b[4]  = state.position;
+  b[5]  = state.position >> 8;
+  b[6]  = state.position >> 16;
+  b[7]  = state.position >> 24;
+  b[8]  = (INT16U) state.velocity;
+  b[9]  = (INT16U) state.velocity >> 8;
+  b[10] = state.throttle;
+  b[11] = 0;
+  *len  = 12;
+}
+
+__attribute__((constructor))
+static void vehicle_trace_init(void)
+{
+  alt_host_trace_set(vehicle_trace_sample);
+}
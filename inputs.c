@@ -0,0 +1,26 @@
+#include "inputs.h"
+
+#define INPUT_STATE(flags, flag) (((flags) & (flag)) ? on : off)
+
+/*
+ * The function 'input_snapshot_take()' reads all flags of 'pgrp' at once.
+ * It never blocks, so the caller sees one consistent set of inputs and
+ * its execution time does not depend on the pedal state.
+ */
+INT8U input_snapshot_take(OS_FLAG_GRP *pgrp, struct input_snapshot *in)
+{
+  INT8U err;
+  OS_FLAGS flags;
+
+  flags = OSFlagQuery(pgrp, &err);
+  if (err != OS_NO_ERR)
+    return err;
+
+  in->flags         = flags;
+  in->engine        = INPUT_STATE(flags, ENGINE_FLAG);
+  in->top_gear      = INPUT_STATE(flags, TOP_GEAR_FLAG);
+  in->gas_pedal     = INPUT_STATE(flags, GAS_PEDAL_FLAG);
+  in->brake_pedal   = INPUT_STATE(flags, BRAKE_PEDAL_FLAG);
+  in->cruise_button = INPUT_STATE(flags, CRUISE_CONTROL_FLAG);
+  return OS_NO_ERR;
+}
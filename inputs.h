@@ -0,0 +1,33 @@
+/*
+ * Input snapshot: one non-blocking read of the EngineStatus flags,
+ * decoded into the pedal and switch states
+ */
+#ifndef INPUTS_H_
+#define INPUTS_H_
+
+#include "includes.h"
+#include "vehicle.h"
+
+/* Button Patterns */
+
+#define GAS_PEDAL_FLAG      0x08
+#define BRAKE_PEDAL_FLAG    0x04
+#define CRUISE_CONTROL_FLAG 0x02
+/* Switch Patterns */
+
+#define TOP_GEAR_FLAG       0x00000010
+#define ENGINE_FLAG         0x00000001
+
+struct input_snapshot {
+  OS_FLAGS    flags;            /* Raw flags of the group */
+  enum active engine;
+  enum active top_gear;
+  enum active gas_pedal;
+  enum active brake_pedal;
+  enum active cruise_button;
+};
+
+/* Leaves '*in' unchanged unless it returns OS_NO_ERR */
+INT8U input_snapshot_take(OS_FLAG_GRP *pgrp, struct input_snapshot *in);
+
+#endif /* INPUTS_H_ */
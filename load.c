@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include "load.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_timestamp.h"
+
+#define LOAD_CALIBRATION_US   200   /* Shortest measured run */
+#define LOAD_CALIBRATION_RUNS 5
+
+struct load_stats load_stats;
+
+static volatile INT32U load_sink;
+
+static void load_spin(INT32U n)
+{
+  INT32U i;
+
+  for (i = 0; i < n; i++)
+    load_sink += i;
+}
+
+/*
+ * The fastest of a few runs of at least LOAD_CALIBRATION_US is taken, as
+ * an interrupt during a run makes it look slower.
+ */
+int load_calibrate(void)
+{
+  alt_timestamp_type t0, t, best = 0;
+  alt_u64 per_us;
+  INT32U n = 64;
+  int run;
+
+  if (alt_timestamp_start() < 0) {
+    printf("No timestamp timer: extra load not calibrated\n");
+    return -1;
+  }
+  per_us = alt_timestamp_freq() / 1000000;
+  if (per_us == 0)
+    per_us = 1;
+
+  /* Iterations for one run */
+  do {
+    n *= 2;
+    t0 = alt_timestamp();
+    load_spin(n);
+    t = alt_timestamp() - t0;
+  } while (t < LOAD_CALIBRATION_US * per_us && n < 0x1000000);
+
+  for (run = 0; run < LOAD_CALIBRATION_RUNS; run++) {
+    t0 = alt_timestamp();
+    load_spin(n);
+    t = alt_timestamp() - t0;
+    if (best == 0 || t < best)
+      best = t;
+  }
+  if (best == 0) {
+    printf("Timestamp timer stands still: extra load not calibrated\n");
+    return -1;
+  }
+  load_stats.iter_per_ms = (INT32U) ((alt_u64) n * 1000 * per_us / best);
+  if (load_stats.iter_per_ms == 0)
+    load_stats.iter_per_ms = 1;
+  printf("Extra load: %lu iterations per ms\n",
+         (unsigned long) load_stats.iter_per_ms);
+  return 0;
+}
+
+void load_burn_us(INT32U us)
+{
+  alt_irq_context context;
+  INT32U slice;
+
+  while (us > 0) {
+    slice = us < LOAD_SLICE_US ? us : LOAD_SLICE_US;
+    load_spin((INT32U) ((alt_u64) load_stats.iter_per_ms * slice / 1000));
+    us -= slice;
+
+    context = alt_irq_disable_all();
+    load_stats.burnt_us += slice;
+    if (load_stats.burnt_us >= 1000) {
+      load_stats.burnt_ms += load_stats.burnt_us / 1000;
+      load_stats.burnt_us %= 1000;
+    }
+    alt_irq_enable_all(context);
+  }
+}
@@ -0,0 +1,36 @@
+/*
+ * Calibrated synthetic CPU load
+ *
+ * load_calibrate() measures the speed of a busy loop against the
+ * timestamp timer once; load_burn_us() then runs the loop for the number
+ * of iterations that takes 'us' microseconds of CPU time.  Time spent in
+ * higher priority tasks and ISRs meanwhile does not count, so the load is
+ * the same whatever preempts it.
+ *
+ * The loop runs in slices of LOAD_SLICE_US with a short critical section
+ * in between, which accounts the CPU time burnt so far.
+ */
+#ifndef LOAD_H_
+#define LOAD_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+#define LOAD_SLICE_US 1000
+
+struct load_stats {
+  INT32U iter_per_ms;   /* Loop iterations per ms of CPU time */
+  INT32U burnt_ms;      /* CPU time burnt in total */
+  INT32U burnt_us;      /* ... and the us beyond burnt_ms */
+};
+
+extern struct load_stats load_stats;
+
+/*
+ * Needs a timestamp timer that runs while the loop does; returns -1 if
+ * there is none, e.g. in the virtual time of the host
+ */
+int  load_calibrate(void);
+void load_burn_us(INT32U us);
+
+#endif /* LOAD_H_ */
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "log.h"
+#include "sys/alt_irq.h"
+#include "monitor.h"
+#include "dump.h"
+
+#define LOG_BARRIER() __asm__ __volatile__ ("" : : : "memory")
+
+struct log_stats log_stats;
+
+#if CRUISE_LOG
+static struct log_record log_ring[LOG_RING_SIZE];
+static volatile INT32U   log_head;   /* Records claimed by producers */
+static volatile INT32U   log_tail;   /* Records taken by LogTask */
+#endif
+
+static void log_print(const struct log_record *rec)
+{
+  const INT32S *a = rec->arg;
+#if CRUISE_FIXED_POINT
+  char velocity_str[16];
+#endif
+
+  switch (rec->event) {
+  case LOG_POSITION:
+    printf("Position: %ldm\n", (long) a[0] / 10);
+    break;
+  case LOG_VELOCITY:
+#if CRUISE_FIXED_POINT
+    /* Same output as %4.1f, without the soft-float printf path */
+    sprintf(velocity_str, "%s%ld.%ld", a[0] < 0 ? "-" : "",
+            labs(a[0]) / 10, labs(a[0]) % 10);
+    printf("Velocity: %4sm/s\n", velocity_str);
+#else
+    printf("Velocity: %4.1fm/s\n", a[0] / 10.0);
+#endif
+    break;
+  case LOG_THROTTLE:
+    printf("Throttle: %ldV\n", (long) a[0] / 10);
+    break;
+  case LOG_CPU_USAGE:
+    printf("CPU usage is %ld%%\n", (long) a[0]);
+    break;
+  case LOG_OVERLOAD:
+    printf("System Overload---------------------------------\n");
+    break;
+  case LOG_EXTRA_LOAD:
+    printf("%ld\n", (long) a[0]);
+    break;
+  case LOG_CONTROL_RESPONSE:
+    printf("Control response: max %lu avg %lu.%02lu ticks (%lu cycles)\n",
+           (unsigned long) a[0], (unsigned long) (a[1] / a[2]),
+           (unsigned long) (a[1] * 100 / a[2] % 100), (unsigned long) a[2]);
+    break;
+  case LOG_DEADLINE_MISS:
+    printf("Deadline missed: %s, %ld ticks late\n", monitor_name(a[0]),
+           (long) a[1]);
+    break;
+  case LOG_INPUTS:
+    printf("Inputs: %lu interrupts, %lu bounces, %lu flag posts, "
+           "%lu kernel calls avoided\n", (unsigned long) a[0],
+           (unsigned long) a[1], (unsigned long) a[2], (unsigned long) a[3]);
+    break;
+  default:
+    printf("log: event %u at %lu\n", rec->event, (unsigned long) rec->time);
+  }
+}
+
+/*
+ * The function 'log_event()' can be called from any task or ISR.  The
+ * Nios II has no atomic read-modify-write instruction, so a producer
+ * claims its slot with interrupts disabled for a few instructions; the
+ * record is filled in afterwards and marked complete with its sequence
+ * number.
+ */
+void log_event(INT16U event, INT32S a0, INT32S a1, INT32S a2, INT32S a3)
+{
+#if CRUISE_LOG
+  alt_irq_context context;
+  struct log_record *slot;
+  INT32U index, used;
+
+  context = alt_irq_disable_all();
+  used = log_head - log_tail;
+  if (used >= LOG_RING_SIZE || event >= LOG_EVENT_NUM) {
+    log_stats.dropped++;
+    if (event < LOG_EVENT_NUM)
+      log_stats.dropped_event[event]++;
+    alt_irq_enable_all(context);
+    return;
+  }
+  index = log_head++;
+  log_stats.logged++;
+  if (used + 1 > log_stats.max_used)
+    log_stats.max_used = used + 1;
+  alt_irq_enable_all(context);
+
+  slot = &log_ring[index & (LOG_RING_SIZE - 1)];
+  slot->time   = OSTime;
+  slot->event  = event;
+  slot->arg[0] = a0;
+  slot->arg[1] = a1;
+  slot->arg[2] = a2;
+  slot->arg[3] = a3;
+  LOG_BARRIER();
+  slot->seq    = index + 1;
+#else
+  struct log_record rec;
+
+  rec.seq    = ++log_stats.logged;
+  rec.time   = OSTime;
+  rec.event  = event;
+  rec.arg[0] = a0;
+  rec.arg[1] = a1;
+  rec.arg[2] = a2;
+  rec.arg[3] = a3;
+  log_print(&rec);
+#endif
+}
+
+#if CRUISE_LOG
+/* Takes the oldest complete record, 0 if there is none */
+static int log_take(struct log_record *rec)
+{
+  struct log_record *slot = &log_ring[log_tail & (LOG_RING_SIZE - 1)];
+
+  if (log_tail == log_head || slot->seq != log_tail + 1)
+    return 0;
+  *rec = *slot;
+  LOG_BARRIER();
+  log_tail++;                   /* The slot may be reused from here on */
+  return 1;
+}
+
+/*
+ * The task 'LogTask' prints the logged records and reports drops
+ */
+void LogTask(void* pdata)
+{
+  struct log_record rec;
+  INT32U dropped = 0;
+
+  while(1)
+  {
+    while (log_take(&rec))
+      log_print(&rec);
+    if (log_stats.dropped != dropped) {
+      printf("log: %lu records dropped (%lu in total, ring %d, max used %lu)\n",
+             (unsigned long) (log_stats.dropped - dropped),
+             (unsigned long) log_stats.dropped, LOG_RING_SIZE,
+             (unsigned long) log_stats.max_used);
+      dropped = log_stats.dropped;
+    }
+    dump_poll();
+    monitor_checkin(MON_LOG);
+    OSTimeDlyHMSM(0,0,0,LOG_DRAIN_PERIOD);
+  }
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Deferred binary trace log
+ *
+ * log_event() stores a fixed size record (event, OS tick, arguments) in a
+ * ring buffer; LogTask formats and prints the records at the lowest
+ * application priority, i.e. when the CPU is otherwise idle.  A log call
+ * never blocks and never enters the kernel: when the ring is full the
+ * record is dropped and counted.
+ *
+ * With CRUISE_LOG=0 log_event() prints the record at once, as the
+ * application did before.
+ */
+#ifndef LOG_H_
+#define LOG_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+enum log_event_id {
+  LOG_POSITION,         /* position [0.1 m] */
+  LOG_VELOCITY,         /* velocity [0.1 m/s] */
+  LOG_THROTTLE,         /* throttle [0.1 V] */
+  LOG_CPU_USAGE,        /* OSCPUUsage [%] */
+  LOG_OVERLOAD,
+  LOG_EXTRA_LOAD,       /* usage */
+  LOG_CONTROL_RESPONSE, /* max, sum, cycles [ticks] */
+  LOG_INPUTS,           /* interrupts, bounces, posts, avoided calls */
+  LOG_DEADLINE_MISS,    /* monitor id, lateness [ticks] */
+  LOG_EVENT_NUM
+};
+
+#define LOG_ARGS 4
+
+struct log_record {
+  INT32U seq;           /* Index of the record + 1 once it is complete */
+  INT32U time;          /* OS tick */
+  INT16U event;
+  INT16U reserved;
+  INT32S arg[LOG_ARGS];
+};
+
+struct log_stats {
+  INT32U logged;
+  INT32U dropped;
+  INT32U dropped_event[LOG_EVENT_NUM];
+  INT32U max_used;      /* Highest ring fill level seen */
+};
+
+extern struct log_stats log_stats;
+
+void log_event(INT16U event, INT32S a0, INT32S a1, INT32S a2, INT32S a3);
+
+#define LOG0(ev)             log_event((ev), 0, 0, 0, 0)
+#define LOG1(ev, a)          log_event((ev), (a), 0, 0, 0)
+#define LOG2(ev, a, b)       log_event((ev), (a), (b), 0, 0)
+#define LOG3(ev, a, b, c)    log_event((ev), (a), (b), (c), 0)
+#define LOG4(ev, a, b, c, d) log_event((ev), (a), (b), (c), (d))
+
+#if CRUISE_LOG
+/* The drain task, to be created at the lowest application priority */
+void LogTask(void* pdata);
+#endif
+
+#endif /* LOG_H_ */
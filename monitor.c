@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include "monitor.h"
+#include "dump.h"
+#include "sys/alt_irq.h"
+
+#define MONITOR_TICKS(ms) ((ms) * OS_TICKS_PER_SEC / 1000)
+
+/* The difference of two tick counts, wrap-around safe */
+#define MONITOR_AFTER(a, b) ((INT32S) ((a) - (b)) > 0)
+
+struct monitor_task {
+  const char *name;
+  INT8U       opt;
+  INT32U      released;         /* Periodic: jobs released ... */
+  INT32U      completed;        /* ... and checked in */
+  INT32U      period;           /* Ticks */
+  INT32U      deadline;
+  INT32U      due;              /* Deadline of the pending job */
+  INT32U      next_miss;        /* Scan counts the next miss after this */
+  struct monitor_stats stats;
+};
+
+static struct monitor_task monitor_task[MONITOR_TASK_NUM];
+static monitor_hook        monitor_react;
+
+void monitor_register(INT8U id, const char *name, INT8U opt,
+                      INT32U period_ms, INT32U deadline_ms)
+{
+  struct monitor_task *t;
+  alt_irq_context context;
+
+  if (id >= MONITOR_TASK_NUM)
+    return;
+  t = &monitor_task[id];
+  context = alt_irq_disable_all();
+  t->name     = name;
+  t->opt      = opt;
+  t->released = 0;
+  t->completed = 0;
+  t->period   = MONITOR_TICKS(period_ms);
+  t->deadline = MONITOR_TICKS(deadline_ms);
+  /* A task that is never released or never checks in is caught as well */
+  t->due      = OSTimeGet() + t->deadline +
+                (opt == MONITOR_PERIODIC ? t->period : 0);
+  t->next_miss = t->due;
+  alt_irq_enable_all(context);
+  dump_register(monitor_dump);
+}
+
+void monitor_set_hook(monitor_hook hook)
+{
+  monitor_react = hook;
+}
+
+/*
+ * Called at each release of the periodic task 'id', by the timer callback
+ * or the task itself; can be called from an ISR.  The first release
+ * anchors the deadlines of all jobs.
+ */
+void monitor_release(INT8U id)
+{
+  struct monitor_task *t = &monitor_task[id];
+  alt_irq_context context;
+
+  context = alt_irq_disable_all();
+  if (t->released++ == 0) {
+    t->due = OSTimeGet() + t->deadline;
+    t->next_miss = t->due;
+  }
+  alt_irq_enable_all(context);
+}
+
+/*
+ * Called by task 'id' once per cycle
+ */
+void monitor_checkin(INT8U id)
+{
+  struct monitor_task *t = &monitor_task[id];
+  alt_irq_context context;
+  INT32U now, lateness = 0;
+  INT8U missed = 0;
+
+  now = OSTimeGet();
+  context = alt_irq_disable_all();
+  t->stats.checkins++;
+  if (t->opt == MONITOR_PERIODIC && t->completed == t->released) {
+    /* No job released */
+    alt_irq_enable_all(context);
+    return;
+  }
+  if (MONITOR_AFTER(now, t->due)) {
+    lateness = now - t->due;
+    if (lateness > t->stats.worst_lateness)
+      t->stats.worst_lateness = lateness;
+    /* Not counted by monitor_scan() yet */
+    if (!MONITOR_AFTER(t->next_miss, t->due)) {
+      t->stats.misses++;
+      missed = 1;
+    }
+  }
+  if (t->opt == MONITOR_HEARTBEAT) {
+    t->due = now + t->deadline;
+    t->next_miss = t->due;
+  } else {
+    t->completed++;
+    t->due += t->period;
+    if (MONITOR_AFTER(t->due, t->next_miss))
+      t->next_miss = t->due;
+  }
+  alt_irq_enable_all(context);
+
+  if (missed && monitor_react != NULL)
+    monitor_react(id, lateness);
+}
+
+/*
+ * Counts a miss for every task that is late and has not checked in: once
+ * per pending job, or per deadline of silence for a heartbeat
+ */
+void monitor_scan(void)
+{
+  struct monitor_task *t;
+  alt_irq_context context;
+  INT32U now, lateness;
+  INT8U id, missed;
+
+  now = OSTimeGet();
+  for (id = 0; id < MONITOR_TASK_NUM; id++) {
+    t = &monitor_task[id];
+    if (t->name == NULL)
+      continue;
+    missed = 0;
+    context = alt_irq_disable_all();
+    lateness = now - t->due;
+    if (MONITOR_AFTER(now, t->due) && lateness > t->stats.worst_lateness)
+      t->stats.worst_lateness = lateness;
+    if (MONITOR_AFTER(now, t->next_miss)) {
+      t->stats.misses++;
+      t->next_miss += t->opt == MONITOR_HEARTBEAT ? t->deadline : t->period;
+      missed = 1;
+    }
+    alt_irq_enable_all(context);
+    if (missed && monitor_react != NULL)
+      monitor_react(id, lateness);
+  }
+}
+
+/*
+ * First tick at which monitor_scan() can count a miss, so that the scan
+ * task can sleep until then; a check-in only moves it later
+ */
+INT32U monitor_next_due(void)
+{
+  alt_irq_context context;
+  INT32U next = 0;
+  INT8U id, any = 0;
+
+  context = alt_irq_disable_all();
+  for (id = 0; id < MONITOR_TASK_NUM; id++) {
+    if (monitor_task[id].name == NULL)
+      continue;
+    if (!any || MONITOR_AFTER(next, monitor_task[id].next_miss))
+      next = monitor_task[id].next_miss;
+    any = 1;
+  }
+  alt_irq_enable_all(context);
+  return any ? next + 1 : OSTimeGet() + MONITOR_TICKS(MONITOR_SCAN_PERIOD);
+}
+
+/*
+ * Queries
+ */
+const char *monitor_name(INT8U id)
+{
+  if (id >= MONITOR_TASK_NUM || monitor_task[id].name == NULL)
+    return "?";
+  return monitor_task[id].name;
+}
+
+INT8U monitor_query(INT8U id, struct monitor_stats *stats)
+{
+  alt_irq_context context;
+
+  if (id >= MONITOR_TASK_NUM || monitor_task[id].name == NULL)
+    return OS_ERR_TASK_NOT_EXIST;
+  context = alt_irq_disable_all();
+  *stats = monitor_task[id].stats;
+  alt_irq_enable_all(context);
+  return OS_NO_ERR;
+}
+
+void monitor_dump(void)
+{
+  struct monitor_stats stats;
+  INT8U id;
+
+  printf("Deadlines [ticks]     period deadline checkins   misses"
+         "    worst\n");
+  for (id = 0; id < MONITOR_TASK_NUM; id++) {
+    if (monitor_task[id].name == NULL)
+      continue;
+    monitor_query(id, &stats);
+    printf("%-18s %9lu %8lu %8lu %8lu %8lu\n", monitor_task[id].name,
+           (unsigned long) monitor_task[id].period,
+           (unsigned long) monitor_task[id].deadline,
+           (unsigned long) stats.checkins, (unsigned long) stats.misses,
+           (unsigned long) stats.worst_lateness);
+  }
+}
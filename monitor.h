@@ -0,0 +1,68 @@
+/*
+ * Deadline monitor of the tasks
+ *
+ * Each monitored task is registered with its period and deadline and
+ * checks in once per cycle, when its job is complete.  There are two
+ * kinds of tasks:
+ *
+ *   MONITOR_PERIODIC   released every period, by a timer or by itself,
+ *                      which reports each release with
+ *                      monitor_release(); the first job is due a
+ *                      deadline after the first release, and every
+ *                      further one a period after its predecessor.  A
+ *                      check-in with no job released, e.g. before the
+ *                      first release, is not a job
+ *   MONITOR_HEARTBEAT  delays itself after each cycle; the next check-in
+ *                      is due a deadline after the last one
+ *
+ * A check-in costs O(1) and never prints.  monitor_scan(), called
+ * periodically by a high priority task, finds the tasks that have not
+ * checked in by their deadline at all, e.g. because they are starved.
+ * Each miss is counted once and passed to the reaction hook with its
+ * lateness so far; the hook runs in the task that checks in or scans and
+ * must not block.
+ *
+ * Times are in OS ticks.
+ */
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+enum monitor_id {
+  MON_VEHICLE,
+  MON_CONTROL,
+  MON_SHOWCPU,
+  MON_EXTRALOAD,
+  MON_OVERLOAD,         /* OverloadDetection, the background heartbeat */
+  MON_DISPLAY,
+  MON_LOG,
+  MONITOR_TASK_NUM
+};
+
+#define MONITOR_PERIODIC  0
+#define MONITOR_HEARTBEAT 1
+
+struct monitor_stats {
+  INT32U checkins;
+  INT32U misses;
+  INT32U worst_lateness;        /* Ticks */
+};
+
+typedef void (*monitor_hook)(INT8U id, INT32U lateness);
+
+void  monitor_register(INT8U id, const char *name, INT8U opt,
+                       INT32U period_ms, INT32U deadline_ms);
+void  monitor_set_hook(monitor_hook hook);
+
+void  monitor_release(INT8U id);
+void  monitor_checkin(INT8U id);
+void  monitor_scan(void);
+INT32U monitor_next_due(void);
+
+const char *monitor_name(INT8U id);
+INT8U monitor_query(INT8U id, struct monitor_stats *stats);
+void  monitor_dump(void);
+
+#endif /* MONITOR_H_ */
@@ -0,0 +1,104 @@
+#include <string.h>
+#include "mpc.h"
+#include "track.h"
+
+#define MPC_THROTTLE_MAX 80
+#define MPC_ERROR_MAX    300    /* 0.1 m/s, keeps the cost in 32 bits */
+
+int mpc_init(struct mpc *m, INT8U horizon, INT8U blocks, INT8U throttle)
+{
+  INT8U b;
+
+  if (blocks < 1 || blocks > MPC_BLOCKS_MAX || horizon < blocks ||
+      horizon % blocks != 0)
+    return -1;
+  m->horizon  = horizon;
+  m->blocks   = blocks;
+  m->throttle = throttle;
+  m->segment  = 0;
+  for (b = 0; b < blocks; b++)
+    m->u[b] = throttle;
+  return 0;
+}
+
+/*
+ * Predicts the blocks from 'from' on with the throttles 'u', starting at
+ * node[from]; fills node[from + 1 .. blocks] and returns the total cost
+ */
+static INT32U mpc_predict(struct mpc *m, const INT8U *u, INT8U from,
+                          struct mpc_node *node, INT16U target,
+                          const INT8S *slope)
+{
+  INT8U per_block = m->horizon / m->blocks, b, k;
+  struct vehicle_plant p = node[from].plant;
+  INT16U segment = node[from].segment;
+  INT32U cost = node[from].cost;
+  INT32S e, du;
+
+  for (b = from; b < m->blocks; b++) {
+    du = (INT32S) u[b] - (b == 0 ? m->throttle : u[b - 1]);
+    cost += MPC_R * du * du;
+    for (k = 0; k < per_block; k++) {
+      vehicle_plant_step(&p, vehicle_acceleration(&p, u[b],
+                           slope != NULL ? slope[segment] :
+                                           track[segment].slope),
+                         off, CONTROL_PERIOD);
+      segment = track_find(p.position, segment);
+      e = (INT32S) p.velocity - target;
+      if (e > MPC_ERROR_MAX)
+        e = MPC_ERROR_MAX;
+      else if (e < -MPC_ERROR_MAX)
+        e = -MPC_ERROR_MAX;
+      cost += MPC_Q * e * e;
+    }
+    node[b + 1].plant   = p;
+    node[b + 1].segment = segment;
+    node[b + 1].cost    = cost;
+  }
+  m->steps += (INT32U) (m->blocks - from) * per_block;
+  return cost;
+}
+
+INT8U mpc_solve(struct mpc *m, INT32U position, INT16S velocity,
+                INT16U target, const INT8S *slope)
+{
+  INT8U u[MPC_BLOCKS_MAX], step = MPC_STEP, b, improved;
+  INT16S d, x;
+
+  m->iterations = 0;
+  m->steps = 0;
+  m->segment = track_find(position, m->segment);
+  m->best[0].plant = (struct vehicle_plant) { position, velocity, 0, 0 };
+  m->best[0].segment = m->segment;
+  m->best[0].cost = 0;
+  mpc_predict(m, m->u, 0, m->best, target, slope);
+
+  while (m->iterations < MPC_ITERATIONS) {
+    m->iterations++;
+    improved = 0;
+    for (b = 0; b < m->blocks; b++)
+      for (d = -step; d <= step; d += 2 * step) {
+        x = (INT16S) m->u[b] + d;
+        if (x < 0 || x > MPC_THROTTLE_MAX)
+          continue;
+        memcpy(u, m->u, m->blocks);
+        u[b] = (INT8U) x;
+        m->trial[b] = m->best[b];
+        if (mpc_predict(m, u, b, m->trial, target, slope) <
+            m->best[m->blocks].cost) {
+          m->u[b] = u[b];
+          memcpy(&m->best[b + 1], &m->trial[b + 1],
+                 (m->blocks - b) * sizeof(m->best[0]));
+          improved = 1;
+          break;
+        }
+      }
+    if (!improved) {
+      if (step == 1)
+        break;
+      step /= 2;
+    }
+  }
+  m->throttle = m->u[0];
+  return m->throttle;
+}
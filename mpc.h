@@ -0,0 +1,64 @@
+/*
+ * Look-ahead cruise controller (CRUISE_CONTROLLER 2)
+ *
+ * Each control cycle mpc_solve() chooses the throttle sequence over the
+ * next 'horizon' control periods that minimises
+ *
+ *   MPC_Q * sum over the steps of (velocity - target)^2
+ *   + MPC_R * sum over the blocks of (throttle change)^2
+ *
+ * on the prediction of the plant model of VehicleTask (vehicle_plant_step
+ * with vehicle_acceleration) over the slopes of the track ahead, and
+ * returns the first throttle of it.  The sequence is held constant over
+ * 'blocks' equal blocks of the horizon.  The solver is a pattern search in
+ * integers: each iteration moves each block by +-step and takes the first
+ * move that lowers the cost, and the step halves from MPC_STEP to 1 when
+ * no move does.  An iteration costs at most 2 * blocks predictions of the
+ * rest of the horizon from the block on, and there are at most
+ * MPC_ITERATIONS of them, so a solve costs at most
+ * MPC_ITERATIONS * 2 * blocks * horizon plant steps (mpc_bound).  The
+ * states at the block starts of the best sequence are kept, so a move of
+ * a later block predicts only from its start.  The search starts from the
+ * sequence of the last cycle.
+ */
+#ifndef MPC_H_
+#define MPC_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+#include "vehicle.h"
+
+struct mpc_node {
+  struct vehicle_plant plant;   /* At the start of a block */
+  INT16U segment;
+  INT32U cost;                  /* Of the steps before it */
+};
+
+struct mpc {
+  INT8U  horizon;               /* Control periods, a multiple of blocks */
+  INT8U  blocks;                /* 1 to MPC_BLOCKS_MAX */
+  INT8U  u[MPC_BLOCKS_MAX];     /* Throttle of each block, 0.1 V */
+  INT8U  throttle;              /* Applied in the last cycle */
+  INT16U segment;               /* Of the last solve, a hint */
+  /* Of the last solve */
+  INT16U iterations;
+  INT32U steps;                 /* Plant steps predicted */
+  struct mpc_node best[MPC_BLOCKS_MAX + 1];
+  struct mpc_node trial[MPC_BLOCKS_MAX + 1];
+};
+
+/* Starts the sequence at 'throttle'; returns -1 for a bad horizon */
+int   mpc_init(struct mpc *m, INT8U horizon, INT8U blocks, INT8U throttle);
+
+/*
+ * Throttle for the vehicle at 'position' and 'velocity' to hold 'target'
+ * [0.1 m/s]; 'slope' gives the slope of each segment, NULL those of the
+ * track table
+ */
+INT8U mpc_solve(struct mpc *m, INT32U position, INT16S velocity,
+                INT16U target, const INT8S *slope);
+
+/* Plant steps of a solve at the most */
+#define mpc_bound(m) ((INT32U) MPC_ITERATIONS * 2 * (m)->blocks * (m)->horizon)
+
+#endif /* MPC_H_ */
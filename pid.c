@@ -0,0 +1,102 @@
+#include "pid.h"
+
+/*
+ * Fixed point PID: the gains are scaled by 2^PID_FRAC_BITS at compile
+ * time, so a step costs three integer multiplications.
+ */
+void PID_reset_fixed(struct _pid *p){
+  p->SetSpeed=0;
+  p->err=0;
+  p->err_last=0;
+  p->voltage=0;
+  p->integral=0;
+}
+
+void PID_init_fixed(struct _pid *p){
+  PID_reset_fixed(p);
+  p->Kp=PID_GAIN(PID_KP);
+  p->Ki=PID_GAIN(PID_KI_STEP);
+  p->Kd=PID_GAIN(PID_KD_STEP);
+}
+
+INT16S PID_realize_fixed(struct _pid *p, INT16U speed, INT16U velocity){
+  INT32S acc;
+
+  p->SetSpeed=speed;           //设定值
+  p->err=p->SetSpeed-velocity; //设定值-实际值
+  p->integral+=p->err;         //积分值，偏差累加
+  acc=p->Kp*p->err+p->Ki*p->integral+p->Kd*(p->err-p->err_last);
+  /*
+   * Division by a power of two truncates toward zero, as the conversion
+   * of the float result did; the compiler emits shifts, no divide
+   */
+  p->voltage=acc/(1<<PID_FRAC_BITS);
+  p->err_last=p->err;          //上一个偏差值
+  return p->voltage;
+}
+
+#if CRUISE_FLOAT_REFERENCE
+void PID_init_float(struct _pid_float *p){
+  p->SetSpeed=0;
+  p->err=0;
+  p->err_last=0;
+  p->voltage=0;
+  p->integral=0;
+  p->Kp=PID_KP;       //自己设定
+  p->Ki=PID_KI_STEP;  //自己设定
+  p->Kd=PID_KD_STEP;  //自己设定
+}
+
+INT16S PID_realize_float(struct _pid_float *p, INT16U speed, INT16U velocity){
+  p->SetSpeed=speed;           //设定值
+  p->err=p->SetSpeed-velocity; //设定值-实际值
+  p->integral+=p->err;         //积分值，偏差累加
+  p->voltage=p->Kp*p->err+p->Ki*p->integral+p->Kd*(p->err-p->err_last);
+  p->err_last=p->err;          //上一个偏差值
+  return p->voltage;
+}
+#endif
+
+//项目中获取到的参数
+void PID_init(struct pid_state *s){
+#if CRUISE_FIXED_POINT
+  PID_init_fixed(&s->p);
+#else
+  PID_init_float(&s->p);
+#endif
+}
+
+INT16S PID_realize(struct pid_state *s, INT16U speed, INT16U velocity){
+#if CRUISE_FIXED_POINT
+  return PID_realize_fixed(&s->p, speed, velocity);
+#else
+  return PID_realize_float(&s->p, speed, velocity);
+#endif
+}
+
+void PID_init_ff(struct _pid *p){
+  PID_init_fixed(p);
+  p->Kp=PID_GAIN(PID_FF_KP);
+  p->Ki=PID_GAIN(PID_FF_KI_STEP);
+  p->Kd=PID_GAIN(PID_FF_KD_STEP);
+}
+
+INT8U PID_throttle_ff(struct _pid *p, INT16U speed, INT16U velocity,
+                      INT8U feedforward){
+  INT32S throttle=feedforward+PID_realize_fixed(p, speed, velocity);
+
+  if (throttle<0 || throttle>80) {
+    /* No integration while saturated */
+    p->integral-=p->err;
+    throttle=throttle<0 ? 0 : 80;
+  }
+  return (INT8U)throttle;
+}
+
+INT8U PID_throttle(INT16S voltage){
+  INT32S throttle=2*(((INT32S)voltage*voltage)/10000+1);
+
+  if (throttle>80)
+    throttle=80;
+  return (INT8U)throttle;
+}
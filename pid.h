@@ -0,0 +1,68 @@
+/*
+ *  Incremented PID for speed control
+ */
+#ifndef PID_H_
+#define PID_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+struct _pid{
+INT16U SetSpeed;     //定义设定值
+INT16U ActualSpeed;    //定义实际值
+INT16S err;        //定义偏差值
+INT16S err_last;     //定义上一个偏差值
+INT32S Kp,Ki,Kd;     //比例、积分、微分系数 (PID_FRAC_BITS fraction bits)
+INT16S voltage;      //定义电压值（控制执行器的变量）
+INT16S integral;       //定义积分值
+};
+
+void   PID_init_fixed(struct _pid *p);
+/* Clears the state of 'p' and keeps its gains */
+void   PID_reset_fixed(struct _pid *p);
+INT16S PID_realize_fixed(struct _pid *p, INT16U speed, INT16U velocity);
+
+#if CRUISE_FLOAT_REFERENCE
+struct _pid_float{
+INT16U SetSpeed;
+INT16U ActualSpeed;
+INT16S err;
+INT16S err_last;
+float Kp,Ki,Kd;
+INT16S voltage;
+INT16S integral;
+};
+
+void   PID_init_float(struct _pid_float *p);
+INT16S PID_realize_float(struct _pid_float *p, INT16U speed, INT16U velocity);
+#endif
+
+/*
+ * The controller of the application, in the arithmetic selected by
+ * CRUISE_FIXED_POINT; each cruise control instance has its own (cruise.h)
+ */
+struct pid_state {
+#if CRUISE_FIXED_POINT
+  struct _pid       p;
+#else
+  struct _pid_float p;
+#endif
+};
+
+void   PID_init(struct pid_state *s);
+INT16S PID_realize(struct pid_state *s, INT16U speed, INT16U velocity);
+
+/* Throttle [0.1 V, 0 to 80] for the output of PID_realize() */
+INT8U  PID_throttle(INT16S voltage);
+
+/*
+ * Feedforward controller (CRUISE_CONTROLLER 1): the throttle is the
+ * feedforward plus the output of a fixed point PID with the gains
+ * PID_FF_K*, in 0.1 V per 0.1 m/s.  While the throttle saturates the
+ * error is not integrated.
+ */
+void   PID_init_ff(struct _pid *p);
+INT8U  PID_throttle_ff(struct _pid *p, INT16U speed, INT16U velocity,
+                       INT8U feedforward);
+
+#endif /* PID_H_ */
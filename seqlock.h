@@ -0,0 +1,53 @@
+/*
+ * Single writer, multiple reader sequence lock
+ *
+ * The block holds two copies of the data.  The writer bumps the sequence
+ * number before it updates each copy, so readers always copy the one that
+ * is not being written: a reader never waits for the writer, even if it
+ * preempted the writer in the middle of an update, and it never enters
+ * the kernel.  A reader retries only if the writer completed an update
+ * while it was copying.
+ *
+ *   SEQLOCK(struct foo) blk;
+ *   SEQLOCK_WRITE(&blk, value);      (one task only)
+ *   SEQLOCK_READ(&blk, copy);        (any task or ISR)
+ *
+ * The barriers only stop the compiler from reordering; this is enough on
+ * the single core Nios II.
+ */
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include "includes.h"
+
+#define SEQLOCK_BARRIER() __asm__ __volatile__ ("" : : : "memory")
+
+#define SEQLOCK(type)                                                  \
+  struct {                                                             \
+    volatile INT32U seq;      /* Readers use data[seq & 1] */           \
+    type            data[2];                                           \
+  }
+
+#define SEQLOCK_WRITE(blk, value)                                      \
+  do {                                                                 \
+    (blk)->seq++;                                                      \
+    SEQLOCK_BARRIER();                                                 \
+    (blk)->data[0] = (value);                                          \
+    SEQLOCK_BARRIER();                                                 \
+    (blk)->seq++;                                                      \
+    SEQLOCK_BARRIER();                                                 \
+    (blk)->data[1] = (value);                                          \
+  } while (0)
+
+#define SEQLOCK_READ(blk, copy)                                        \
+  do {                                                                 \
+    INT32U seq_;                                                       \
+    do {                                                               \
+      seq_ = (blk)->seq;                                               \
+      SEQLOCK_BARRIER();                                               \
+      (copy) = (blk)->data[seq_ & 1];                                  \
+      SEQLOCK_BARRIER();                                               \
+    } while (seq_ != (blk)->seq);                                      \
+  } while (0)
+
+#endif /* SEQLOCK_H_ */
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <ctype.h>
+#include "stack_watch.h"
+#include "dump.h"
+#include "sys/alt_irq.h"
+
+#if CRUISE_STACK_WATCH
+
+#if OS_STK_GROWTH != 1
+#error "stack_watch.c expects stacks that grow down"
+#endif
+
+#define STACK_ROUND 8           /* Proposed sizes are multiples of this */
+
+struct stack_task {
+  const char *name;
+  OS_STK     *bottom;           /* Lowest word of the stack the task runs on */
+  INT32U      words;            /* Its size, at least 'size' */
+  INT32U      size;             /* Words requested by the application */
+  INT32U      free;             /* Untouched words above 'bottom' */
+  INT32U      peak_tick;
+};
+
+static struct stack_task stack_task[OS_LOWEST_PRIO + 1];
+static INT8U             stack_prio;            /* Task of the pass */
+static INT32U            stack_cursor;          /* Next word of the pass */
+
+/*
+ * The port may run the task on a bigger stack than the one of the
+ * application, e.g. the host, so the stack is taken from the TCB.
+ */
+void stack_watch_add(INT8U prio, const char *name, INT32U size)
+{
+  struct stack_task *t;
+  alt_irq_context context;
+  OS_TCB *ptcb;
+
+  if (prio > OS_LOWEST_PRIO)
+    return;
+  t = &stack_task[prio];
+  context = alt_irq_disable_all();
+  ptcb = OSTCBPrioTbl[prio];
+  if (ptcb != NULL && ptcb != OS_TCB_RESERVED &&
+      ptcb->OSTCBStkBottom != NULL) {
+    t->name      = name;
+    t->bottom    = ptcb->OSTCBStkBottom;
+    t->words     = ptcb->OSTCBStkSize;
+    t->size      = size;
+    t->free      = t->words;
+    t->peak_tick = 0;
+  }
+  alt_irq_enable_all(context);
+  dump_register(stack_watch_dump);
+}
+
+/*
+ * Called by the idle hook; a deleted task keeps its last watermark
+ */
+void stack_watch_step(void)
+{
+  struct stack_task *t;
+  INT32U budget = STACK_SCAN_WORDS;
+  INT8U tasks = 0;
+
+  while (budget > 0 && tasks <= OS_LOWEST_PRIO) {
+    t = &stack_task[stack_prio];
+    while (stack_cursor < t->free && budget > 0) {
+      if (t->bottom[stack_cursor] != 0) {
+        t->free = stack_cursor;
+        t->peak_tick = OSTimeGet();
+        break;
+      }
+      stack_cursor++;
+      budget--;
+    }
+    if (stack_cursor < t->free && budget == 0)
+      return;
+    /* Pass complete: next task */
+    stack_cursor = 0;
+    stack_prio = (stack_prio + 1) % (OS_LOWEST_PRIO + 1);
+    tasks++;
+  }
+}
+
+/*
+ * Queries
+ */
+static INT32U stack_propose(INT32U used)
+{
+  INT32U margin = used * STACK_MARGIN_PCT / 100;
+
+  if (margin < STACK_MARGIN_MIN)
+    margin = STACK_MARGIN_MIN;
+  return (used + margin + STACK_ROUND - 1) / STACK_ROUND * STACK_ROUND;
+}
+
+INT8U stack_watch_query(INT8U prio, struct stack_usage *usage)
+{
+  struct stack_task *t;
+  alt_irq_context context;
+
+  if (prio > OS_LOWEST_PRIO || stack_task[prio].name == NULL)
+    return OS_ERR_TASK_NOT_EXIST;
+  t = &stack_task[prio];
+  context = alt_irq_disable_all();
+  usage->used      = t->words - t->free;
+  usage->peak_tick = t->peak_tick;
+  alt_irq_enable_all(context);
+
+  /*
+   * A task that runs on a stack of another size than the application's,
+   * as on the host, uses it differently: its use is reported as it is,
+   * and no size is proposed from it
+   */
+  usage->size     = t->size;
+  usage->proposed = t->words == t->size ? stack_propose(usage->used) : 0;
+  return OS_NO_ERR;
+}
+
+void stack_watch_dump(void)
+{
+  struct stack_usage u;
+  INT32U size = 0, proposed = 0;
+  const char *c;
+  INT8U prio, others = 0;
+
+  printf("Stack [words]          size     used  seen at  proposed\n");
+  for (prio = 0; prio <= OS_LOWEST_PRIO; prio++) {
+    if (stack_watch_query(prio, &u) != OS_NO_ERR)
+      continue;
+    printf("%-18s %8lu %8lu %8lu", stack_task[prio].name,
+           (unsigned long) u.size, (unsigned long) u.used,
+           (unsigned long) u.peak_tick);
+    if (u.proposed != 0)
+      printf(" %9lu\n", (unsigned long) u.proposed);
+    else
+      printf(" %9s\n", "-");
+    size     += u.size;
+    proposed += u.proposed;
+    others   += u.proposed == 0;
+  }
+  printf("%-18s %8lu %8s %8s %9lu\n", "Total", (unsigned long) size, "", "",
+         (unsigned long) proposed);
+  if (others > 0)
+    printf("%u tasks run on stacks of the port: used in its words, "
+           "no size proposed\n", others);
+
+  /* For the file named by STACK_SIZES */
+  for (prio = 0; prio <= OS_LOWEST_PRIO; prio++) {
+    if (stack_watch_query(prio, &u) != OS_NO_ERR || u.proposed == 0)
+      continue;
+    printf("#define ");
+    for (c = stack_task[prio].name; *c != '\0'; c++)
+      putchar(toupper((unsigned char) *c));
+    printf("_STACKSIZE %lu\n", (unsigned long) u.proposed);
+  }
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Stack high-watermarks of the tasks
+ *
+ * Each registered task stack is scanned from its bottom for the first
+ * word that is no longer zero, as OSTaskStkChk() does, but a few words at
+ * a time: stack_watch_step() runs in the idle hook and checks at most
+ * STACK_SCAN_WORDS words per call.  A pass over a stack stops at the
+ * watermark of the previous pass, as everything above it is in use
+ * already, so a pass costs no more than the free part of the stack.  The
+ * peak use of every task is kept with the tick at which it was first
+ * seen.
+ *
+ * The stacks must be zero when the task is created (OS_TASK_OPT_STK_CLR
+ * or a cleared .bss) and grow down (OS_STK_GROWTH 1).
+ *
+ * stack_watch_dump() prints the peaks and proposes a size for each task,
+ * the peak plus STACK_MARGIN_PCT % and at least STACK_MARGIN_MIN words,
+ * as lines
+ *
+ *   #define <NAME>_STACKSIZE <words>
+ *
+ * with the task name in upper case, which cruise_skeleton.c reads back
+ * from the file named by STACK_SIZES.  A port that runs a task on a stack
+ * of another size than the application requested, as the host does,
+ * says nothing about the use on the board: such a task gets its use in
+ * words of that stack and no proposal.
+ */
+#ifndef STACK_WATCH_H_
+#define STACK_WATCH_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+struct stack_usage {
+  INT32U size;          /* Words requested by the application */
+  INT32U used;          /* Peak, in words of the stack the task runs on */
+  INT32U peak_tick;     /* OSTimeGet() when 'used' was first seen */
+  INT32U proposed;      /* Suggested size in words, 0: none */
+};
+
+#if CRUISE_STACK_WATCH
+void  stack_watch_add(INT8U prio, const char *name, INT32U size);
+void  stack_watch_step(void);
+
+INT8U stack_watch_query(INT8U prio, struct stack_usage *usage);
+void  stack_watch_dump(void);
+#else
+#define stack_watch_add(prio, name, size)
+#define stack_watch_step()
+#endif
+
+#endif /* STACK_WATCH_H_ */
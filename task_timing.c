@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <string.h>
+#include "task_timing.h"
+#include "dump.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_timestamp.h"
+
+#if CRUISE_TASK_TIMING
+
+#define TIMING_QUEUE 2          /* Released jobs kept before they start */
+
+struct timing_job {
+  alt_timestamp_type release;
+  INT8U              missed;      /* Miss already counted */
+};
+
+struct task_timing {
+  const char        *name;
+  OS_EVENT          *sem;         /* Semaphore that releases the task */
+  INT32U             period;      /* Timestamp ticks */
+  INT8U              pending;     /* Released, not started yet */
+  INT8U              running;     /* Started, not completed yet */
+  INT32U             misses;      /* Deadline (= period) misses */
+  alt_timestamp_type release;     /* Last release, for the jitter */
+  struct timing_job  queue[TIMING_QUEUE];       /* Pending, oldest first */
+  struct timing_job  job;         /* The running job */
+  alt_timestamp_type start;
+  struct timing_hist hist[TIMING_KIND_NUM];
+};
+
+static struct task_timing task_timing[TIMING_TASK_NUM];
+static INT32U             task_timing_per_us;   /* Timestamp ticks per us */
+static INT8U              task_timing_enabled;
+
+static const char *task_timing_kind_name[TIMING_KIND_NUM] = {
+  "latency", "response", "jitter"
+};
+
+/*
+ * Histograms
+ */
+static INT32U timing_bucket(INT32U us)
+{
+  INT32U bit;
+
+  if (us < TIMING_HIST_EXACT)
+    return us;
+  bit = 31 - __builtin_clz(us);
+  if (bit >= TIMING_HIST_MAXBIT)
+    return TIMING_HIST_BUCKETS - 1;
+  return TIMING_HIST_EXACT + (bit - 4) * TIMING_HIST_SUB +
+         ((us >> (bit - 3)) & (TIMING_HIST_SUB - 1));
+}
+
+/* Largest value that falls into bucket 'b' */
+static INT32U timing_bucket_limit(INT32U b)
+{
+  INT32U bit, sub;
+
+  if (b < TIMING_HIST_EXACT)
+    return b;
+  if (b >= TIMING_HIST_BUCKETS - 1)
+    return 0xffffffff;
+  bit = (b - TIMING_HIST_EXACT) / TIMING_HIST_SUB + 4;
+  sub = (b - TIMING_HIST_EXACT) % TIMING_HIST_SUB;
+  return ((TIMING_HIST_SUB + sub + 1) << (bit - 3)) - 1;
+}
+
+static void timing_hist_add(struct timing_hist *h, INT32U us)
+{
+  if (h->count == 0 || us < h->min)
+    h->min = us;
+  if (us > h->max)
+    h->max = us;
+  h->count++;
+  h->bucket[timing_bucket(us)]++;
+}
+
+static INT32U timing_hist_percentile(const struct timing_hist *h,
+                                     INT32U permille)
+{
+  INT32U b, n = 0, rank = (h->count * (alt_u64) permille + 999) / 1000;
+
+  for (b = 0; b < TIMING_HIST_BUCKETS; b++) {
+    n += h->bucket[b];
+    if (n >= rank)
+      break;
+  }
+  /* The bucket limit can exceed what was actually seen */
+  return timing_bucket_limit(b) < h->max ? timing_bucket_limit(b) : h->max;
+}
+
+static INT32U timing_us(alt_timestamp_type ticks)
+{
+  return (INT32U) (ticks / task_timing_per_us);
+}
+
+/*
+ * Setup
+ */
+void task_timing_init(void)
+{
+  if (alt_timestamp_start() < 0) {
+    printf("No timestamp timer: task timing disabled\n");
+    return;
+  }
+  task_timing_per_us = alt_timestamp_freq() / 1000000;
+  if (task_timing_per_us == 0)
+    task_timing_per_us = 1;
+  task_timing_enabled = 1;
+  dump_register(task_timing_dump);
+}
+
+void task_timing_register(INT8U id, const char *name, OS_EVENT *sem,
+                          INT32U period_ms)
+{
+  if (id >= TIMING_TASK_NUM)
+    return;
+  task_timing[id].name   = name;
+  task_timing[id].sem    = sem;
+  task_timing[id].period = period_ms * 1000 * task_timing_per_us;
+}
+
+/*
+ * Instrumentation points
+ */
+
+/* Records the jitter of a release at 'now' */
+static void timing_released(struct task_timing *t, alt_timestamp_type now)
+{
+  alt_timestamp_type interval;
+
+  if (t->release != 0 && t->period != 0) {
+    interval = now - t->release;
+    timing_hist_add(&t->hist[TIMING_JITTER],
+                    timing_us(interval > t->period ? interval - t->period :
+                                                     t->period - interval));
+  }
+  t->release = now;
+}
+
+/* Called by the alarm that drives the software timers (ISR) */
+void task_timing_alarm(void)
+{
+  if (task_timing_enabled)
+    timing_released(&task_timing[TIMING_ALARM], alt_timestamp());
+}
+
+/* Counts the miss of job 'j' once */
+static void timing_missed(struct task_timing *t, struct timing_job *j)
+{
+  if (!j->missed) {
+    j->missed = 1;
+    t->misses++;
+  }
+}
+
+/*
+ * Called when 'sem' is posted to release a periodic task.  Each job keeps
+ * its own release until it starts, so that a job released while the one
+ * before is still pending or running is measured from its release; the
+ * releases beyond TIMING_QUEUE pending jobs are not kept.
+ */
+void task_timing_release(OS_EVENT *sem)
+{
+  struct task_timing *t;
+  alt_timestamp_type now;
+  alt_irq_context context;
+  INT8U id;
+
+  if (!task_timing_enabled)
+    return;
+  now = alt_timestamp();
+  for (id = 0; id < TIMING_TASK_NUM; id++) {
+    t = &task_timing[id];
+    if (t->sem == sem) {
+      context = alt_irq_disable_all();
+      /* Released again before the last job completed */
+      if (t->running)
+        timing_missed(t, &t->job);
+      if (t->pending > 0)
+        timing_missed(t, &t->queue[t->pending - 1]);
+      timing_released(t, now);
+      if (t->pending < TIMING_QUEUE) {
+        t->queue[t->pending].release = now;
+        t->queue[t->pending].missed  = 0;
+        t->pending++;
+      }
+      alt_irq_enable_all(context);
+      return;
+    }
+  }
+}
+
+void task_timing_start(INT8U id)
+{
+  struct task_timing *t = &task_timing[id];
+  alt_irq_context context;
+
+  if (!task_timing_enabled)
+    return;
+  context = alt_irq_disable_all();
+  if (t->pending > 0) {       /* Not the first pass before any release */
+    t->job = t->queue[0];
+    memmove(&t->queue[0], &t->queue[1],
+            (TIMING_QUEUE - 1) * sizeof(t->queue[0]));
+    t->pending--;
+    t->start = alt_timestamp();
+    timing_hist_add(&t->hist[TIMING_LATENCY],
+                    timing_us(t->start - t->job.release));
+    t->running = 1;
+  }
+  alt_irq_enable_all(context);
+}
+
+void task_timing_end(INT8U id)
+{
+  struct task_timing *t = &task_timing[id];
+  alt_timestamp_type response;
+  alt_irq_context context;
+
+  if (!task_timing_enabled)
+    return;
+  context = alt_irq_disable_all();
+  if (t->running) {
+    response = alt_timestamp() - t->job.release;
+    timing_hist_add(&t->hist[TIMING_RESPONSE], timing_us(response));
+    if (t->period != 0 && response > t->period)
+      timing_missed(t, &t->job);
+    t->running = 0;
+  }
+  alt_irq_enable_all(context);
+}
+
+/*
+ * Queries
+ */
+INT8U task_timing_query(INT8U id, INT8U kind, struct timing_summary *sum)
+{
+  struct timing_hist *h;
+  alt_irq_context context;
+
+  if (id >= TIMING_TASK_NUM || task_timing[id].name == NULL)
+    return OS_ERR_TASK_NOT_EXIST;
+  if (kind >= TIMING_KIND_NUM)
+    return OS_ERR_TASK_OPT;
+  h = &task_timing[id].hist[kind];
+  context = alt_irq_disable_all();
+  sum->count = h->count;
+  sum->min   = h->min;
+  sum->max   = h->max;
+  sum->p50   = timing_hist_percentile(h, 500);
+  sum->p90   = timing_hist_percentile(h, 900);
+  sum->p99   = timing_hist_percentile(h, 990);
+  alt_irq_enable_all(context);
+  return OS_NO_ERR;
+}
+
+/* Deadline misses of task 'id' since the last reset */
+INT32U task_timing_misses(INT8U id)
+{
+  return id < TIMING_TASK_NUM ? task_timing[id].misses : 0;
+}
+
+void task_timing_reset(void)
+{
+  alt_irq_context context;
+  INT8U id;
+
+  context = alt_irq_disable_all();
+  for (id = 0; id < TIMING_TASK_NUM; id++) {
+    memset(task_timing[id].hist, 0, sizeof(task_timing[id].hist));
+    task_timing[id].misses = 0;
+  }
+  alt_irq_enable_all(context);
+}
+
+void task_timing_dump(void)
+{
+  struct timing_summary sum;
+  INT8U id, kind;
+
+  printf("Task timing [us]          count      min      p50      p90"
+         "      p99      max\n");
+  for (id = 0; id < TIMING_TASK_NUM; id++) {
+    if (task_timing[id].name == NULL)
+      continue;
+    for (kind = 0; kind < TIMING_KIND_NUM; kind++) {
+      task_timing_query(id, kind, &sum);
+      if (sum.count == 0)
+        continue;
+      printf("%-12s %-9s %8lu %8lu %8lu %8lu %8lu %8lu\n",
+             task_timing[id].name, task_timing_kind_name[kind],
+             (unsigned long) sum.count, (unsigned long) sum.min,
+             (unsigned long) sum.p50, (unsigned long) sum.p90,
+             (unsigned long) sum.p99, (unsigned long) sum.max);
+    }
+  }
+}
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Response time and jitter of the periodic tasks
+ *
+ * Each periodic task is released by a software timer (SemPostFunc), starts
+ * when its OSSemPend() returns and completes when it pends again.  The
+ * three instants are taken from the timestamp timer and accumulated in
+ * fixed size histograms per task:
+ *
+ *   latency   release to start
+ *   response  release to completion
+ *   jitter    deviation of the release interval from the period
+ *
+ * The alarm of the software timers (alarm_handler) gets a jitter histogram
+ * of its own.  All values are in microseconds.
+ *
+ * A job misses its deadline, the period, when it completes later or the
+ * next release comes first; each job counts once.  Latency and response
+ * are measured from the release of the job itself, also when it was
+ * released while the job before was still pending or running.
+ */
+#ifndef TASK_TIMING_H_
+#define TASK_TIMING_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+enum task_timing_id {
+  TIMING_VEHICLE,
+  TIMING_CONTROL,
+  TIMING_SHOWCPU,
+  TIMING_ALARM,         /* Only the jitter of the HW timer alarm */
+  TIMING_TASK_NUM
+};
+
+enum task_timing_kind {
+  TIMING_LATENCY,
+  TIMING_RESPONSE,
+  TIMING_JITTER,
+  TIMING_KIND_NUM
+};
+
+/*
+ * Log-linear buckets: exact below 16 us, then 8 buckets per power of two
+ * up to 2^21 us (12.5 % resolution), plus one overflow bucket.
+ */
+#define TIMING_HIST_EXACT   16
+#define TIMING_HIST_SUB     8
+#define TIMING_HIST_MAXBIT  21
+#define TIMING_HIST_BUCKETS (TIMING_HIST_EXACT + \
+                             (TIMING_HIST_MAXBIT - 4) * TIMING_HIST_SUB + 1)
+
+struct timing_hist {
+  INT32U count;
+  INT32U min;
+  INT32U max;
+  INT32U bucket[TIMING_HIST_BUCKETS];
+};
+
+struct timing_summary {
+  INT32U count;
+  INT32U min;
+  INT32U max;
+  INT32U p50;           /* Percentiles: upper bound of the bucket */
+  INT32U p90;
+  INT32U p99;
+};
+
+#if CRUISE_TASK_TIMING
+void task_timing_init(void);
+void task_timing_register(INT8U id, const char *name, OS_EVENT *sem,
+                          INT32U period_ms);
+
+/* Instrumentation points */
+void task_timing_alarm(void);
+void task_timing_release(OS_EVENT *sem);
+void task_timing_start(INT8U id);
+void task_timing_end(INT8U id);
+
+/* Queries */
+INT8U task_timing_query(INT8U id, INT8U kind, struct timing_summary *sum);
+INT32U task_timing_misses(INT8U id);
+void  task_timing_reset(void);
+void  task_timing_dump(void);
+#else
+#define task_timing_init()
+#define task_timing_register(id, name, sem, period_ms)
+#define task_timing_alarm()
+#define task_timing_release(sem)
+#define task_timing_start(id)
+#define task_timing_end(id)
+#endif
+
+#endif /* TASK_TIMING_H_ */
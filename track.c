@@ -0,0 +1,42 @@
+#include "track.h"
+
+const struct track_segment track[] = {
+#define TRACK_SEGMENT(start, slope, led) { start, slope, led },
+#define TRACK_END(length)
+#include TRACK_TABLE
+#undef TRACK_SEGMENT
+#undef TRACK_END
+};
+
+const INT16U track_segments = sizeof(track) / sizeof(track[0]);
+
+#define TRACK_SEGMENT(start, slope, led)
+#define TRACK_END(length) const INT32U track_length = length;
+#include TRACK_TABLE
+#undef TRACK_SEGMENT
+#undef TRACK_END
+
+INT16U track_find(INT32U position, INT16U hint)
+{
+  INT16U lo, hi, mid;
+
+  /* The segment of the last call or the next one */
+  if (hint < track_segments && position >= track[hint].start) {
+    if (hint + 1 == track_segments || position < track[hint + 1].start)
+      return hint;
+    if (hint + 2 == track_segments || position < track[hint + 2].start)
+      return hint + 1;
+  }
+
+  /* Last segment with start <= position; track[0].start is 0 */
+  lo = 0;
+  hi = track_segments - 1;
+  while (lo < hi) {
+    mid = (lo + hi + 1) / 2;
+    if (track[mid].start <= position)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return lo;
+}
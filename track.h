@@ -0,0 +1,33 @@
+/*
+ * Track profile shared by the vehicle model and the display
+ *
+ * The track is a table of segments, sorted by their start position and
+ * built at compile time from the file TRACK_TABLE (see track_loop.def).
+ * A segment has a slope, which is added to the retardation of the
+ * vehicle, and the red LED that shows it.  The track wraps around at
+ * track_length.
+ */
+#ifndef TRACK_H_
+#define TRACK_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+struct track_segment {
+  INT32U start;         /* 0.1 m */
+  INT8S  slope;         /* Retardation, 0.1 m/s^2 */
+  INT8U  led;           /* LEDR number */
+};
+
+extern const struct track_segment track[];
+extern const INT16U track_segments;
+extern const INT32U track_length;       /* 0.1 m */
+
+/*
+ * Index of the segment at 'position'.  'hint' is a segment to try first,
+ * usually the one of the last call: driving on, the lookup is O(1), any
+ * other position costs a binary search.
+ */
+INT16U track_find(INT32U position, INT16U hint);
+
+#endif /* TRACK_H_ */
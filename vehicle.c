@@ -0,0 +1,312 @@
+#include "vehicle.h"
+#include "track.h"
+
+/*
+ * The function 'adjust_position()' adjusts the position depending on the
+ * acceleration and velocity.  The position wraps around at the end of
+ * the track.
+ */
+INT32U adjust_position(INT32U position, INT16S velocity,
+                       INT8S acceleration, INT16U time_interval)
+{
+  /* a t^2 / 2 with t in ms; exact in 32 bits up to 4 s */
+  INT32S new_position = (INT32S) position + velocity * time_interval / 1000
+    + (INT32S) acceleration * time_interval * time_interval / 2000000;
+
+  if (new_position > (INT32S) track_length) {
+    new_position -= track_length;
+  } else if (new_position < 0){
+    new_position += track_length;
+  }
+
+  return new_position;
+}
+
+#if CRUISE_FLOAT_REFERENCE
+INT16S adjust_velocity_float(INT16S velocity, INT8S acceleration,
+		       enum active brake_pedal, INT16U time_interval)
+{
+  INT16S new_velocity;
+  INT8U brake_retardation = 200;
+
+  if (brake_pedal == off)
+    new_velocity = velocity  + (float) (acceleration * time_interval) / 1000.0;
+  else {
+    if (brake_retardation * time_interval / 1000 > velocity)
+      new_velocity = 0;
+    else
+      new_velocity = velocity - brake_retardation * time_interval / 1000;
+  }
+
+  return new_velocity;
+}
+#endif
+
+#if CRUISE_FIXED_POINT
+/* Splits 'value' (1/1000 units) into whole units and a fraction */
+static INT32S vehicle_split(INT32S value, INT16S *frac)
+{
+  *frac = (INT16S) (value % 1000);
+  return value / 1000;
+}
+#endif
+
+#if CRUISE_FLOAT_REFERENCE
+/* 1/1000 of a unit in 'x' [0.1 m or 0.1 m/s] less 'whole', rounded */
+static INT16S vehicle_frac_float(float x, INT32S whole)
+{
+  float frac = (x - whole) * 1000;
+
+  return (INT16S) (frac >= 0 ? frac + 0.5f : frac - 0.5f);
+}
+
+void vehicle_plant_step_float(struct vehicle_plant *p, INT8S acceleration,
+                              enum active brake_pedal, INT16U time_interval)
+{
+  float dt = time_interval / 1000.0f;
+  float velocity, old = p->velocity + p->velocity_frac / 1000.0f, moved;
+  INT32S position;
+
+  if (brake_pedal == off)
+    velocity = old + acceleration * dt;
+  else if (200 * dt > old)
+    velocity = 0;
+  else
+    velocity = old - 200 * dt;
+  if ((old > 0 && velocity < 0) || (old < 0 && velocity > 0))
+    velocity = 0;
+
+  moved = p->position_frac / 1000.0f + (old + velocity) / 2 * dt;
+  position = (INT32S) p->position + (INT32S) moved;
+  p->position_frac = vehicle_frac_float(moved, (INT32S) moved);
+  if (position > (INT32S) track_length)
+    position -= track_length;
+  else if (position < 0)
+    position += track_length;
+  p->position = position;
+  p->velocity = (INT16S) velocity;
+  p->velocity_frac = vehicle_frac_float(velocity, p->velocity);
+}
+#endif
+
+/*
+ * The function 'vehicle_plant_step()' is 'adjust_position()' and
+ * 'adjust_velocity()' with the fractions carried over, for an interval
+ * of 'time_interval' ms.  The velocity does not change its sign within
+ * a step: a vehicle that would turn around stops at 0.  The position moves
+ * by the mean of the old and the new velocity, v t + a t^2 / 2; the a t^2
+ * term is split so that its product stays in 32 bits for any interval.
+ */
+void vehicle_plant_step(struct vehicle_plant *p, INT8S acceleration,
+                        enum active brake_pedal, INT16U time_interval)
+{
+#if CRUISE_FIXED_POINT
+  INT32S position, velocity, old, dv;
+  INT32S brake = 200 * (INT32S) time_interval;
+
+  old = velocity = (INT32S) p->velocity * 1000 + p->velocity_frac;
+  if (brake_pedal == off)
+    velocity += (INT32S) acceleration * time_interval;
+  else if (brake > velocity)
+    velocity = 0;
+  else
+    velocity -= brake;
+  if ((old > 0 && velocity < 0) || (old < 0 && velocity > 0))
+    velocity = 0;
+
+  /* 1/1000 of 0.1 m: v t, its fraction and dv t / 2 */
+  dv = velocity - old;
+  position = (INT32S) p->position + vehicle_split((INT32S) p->position_frac
+               + (INT32S) p->velocity * time_interval
+               + (INT32S) p->velocity_frac * time_interval / 1000
+               + dv / 2000 * time_interval
+               + dv % 2000 * time_interval / 2000, &p->position_frac);
+  if (position > (INT32S) track_length)
+    position -= track_length;
+  else if (position < 0)
+    position += track_length;
+  p->position = position;
+  p->velocity = vehicle_split(velocity, &p->velocity_frac);
+#else
+  vehicle_plant_step_float(p, acceleration, brake_pedal, time_interval);
+#endif
+}
+
+/*
+ * Half the throttle less the retardation, the wind resistance and the
+ * slope.  The constant part of the wind factor is rolling resistance: it
+ * holds a vehicle at rest but does not set it moving.
+ */
+static inline INT8S vehicle_accel(const struct vehicle_plant *p,
+                                  INT8U throttle, INT8S slope,
+                                  INT16U wind_div, INT8S rolling)
+{
+  INT16S wind_factor;   /* Value between -10 and 20 (2.0 m/s^2 and -1.0 m/s^2) */
+  INT16S acceleration;
+
+  if (p->velocity > 0)
+    wind_factor = p->velocity * p->velocity / wind_div + rolling;
+  else
+    wind_factor = (-1) * p->velocity * p->velocity / wind_div + rolling;
+
+  acceleration = throttle / 2 - (wind_factor + slope);
+  if (VEHICLE_AT_REST(p) && acceleration >= -rolling && acceleration <= rolling)
+    acceleration = 0;
+  return (INT8S) acceleration;
+}
+
+/* The divisor is a constant here, which the compiler folds */
+INT8S vehicle_acceleration(const struct vehicle_plant *p, INT8U throttle,
+                           INT8S slope)
+{
+  return vehicle_accel(p, throttle, slope, VEHICLE_WIND_DIV, VEHICLE_ROLLING);
+}
+
+INT8S vehicle_acceleration_drag(const struct vehicle_plant *p, INT8U throttle,
+                                INT8S slope, const struct vehicle_drag *drag)
+{
+  return vehicle_accel(p, throttle, slope, drag->wind_div, drag->rolling);
+}
+
+INT8U vehicle_feedforward(INT16S velocity, INT8S slope)
+{
+  INT32S throttle = 2 * ((INT32S) velocity * velocity / VEHICLE_WIND_DIV +
+                         VEHICLE_ROLLING + slope);
+
+  return throttle < 0 ? 0 : throttle > 80 ? 80 : (INT8U) throttle;
+}
+
+/*
+ * Q-format integrator
+ */
+
+/* x / d rounded to the nearest, d > 0 */
+static INT32S vehicle_div_round(INT32S x, INT32S d)
+{
+  return x >= 0 ? (x + d / 2) / d : -((-x + d / 2) / d);
+}
+
+/* Position wrapped into the track */
+static INT32S vehicle_q_wrap(INT32S x)
+{
+  INT32S length = (INT32S) track_length << VEHICLE_Q_BITS;
+
+  if (x >= length)
+    x -= length;
+  else if (x < 0)
+    x += length;
+  return x;
+}
+
+/*
+ * Acceleration [0.1 m/s^2 Q8] at position x and velocity v.  The wind
+ * factor v^2 / wind_div is formed in 32 bits from v (Q8) times v / 16 for
+ * velocities up to 70 m/s, and faster ones are taken as 70 m/s.
+ */
+static INT32S vehicle_q_accel(struct vehicle_q *p,
+                              const struct vehicle_integrator *in,
+                              const struct vehicle_drag *drag,
+                              INT8U throttle, INT32S x, INT32S v)
+{
+  INT32S speed = v < 0 ? -v : v, wind, a;
+  INT8S slope;
+
+  if (speed > 700L << VEHICLE_Q_BITS)
+    speed = 700L << VEHICLE_Q_BITS;
+  p->segment = track_find((INT32U) (vehicle_q_wrap(x) >> VEHICLE_Q_BITS),
+                          p->segment);
+  slope = in->slope != NULL ? in->slope[p->segment] : track[p->segment].slope;
+  wind = speed * (speed >> 4) / (16L * drag->wind_div);
+  if (v < 0)
+    wind = -wind;
+  a = (INT32S) throttle * VEHICLE_Q_ONE / 2 - wind -
+      ((INT32S) drag->rolling + slope) * VEHICLE_Q_ONE;
+  if (v == 0 && a >= -drag->rolling * VEHICLE_Q_ONE &&
+      a <= drag->rolling * VEHICLE_Q_ONE)
+    a = 0;
+  return a;
+}
+
+void vehicle_integrate(struct vehicle_q *p, const struct vehicle_integrator *in,
+                       INT8U throttle, enum active brake_pedal,
+                       INT16U time_interval)
+{
+  static const struct vehicle_drag board = { VEHICLE_WIND_DIV, VEHICLE_ROLLING };
+  const struct vehicle_drag *drag = in->drag != NULL ? in->drag : &board;
+  INT8U n = in->substeps > 0 ? in->substeps : 1, i;
+  INT32S h, x, v, v0, a, k[4], kx[4];
+
+  for (i = 0; i < n; i++) {
+    /* Sub-steps of equal length, the remainder spread over them */
+    h = (INT32S) time_interval * (i + 1) / n - (INT32S) time_interval * i / n;
+    x = p->position;
+    v0 = v = p->velocity;
+
+    if (brake_pedal == on) {
+      /* 20 m/s^2 down to 0, the position with the mean velocity */
+      v = v - 200 * VEHICLE_Q_ONE * h / 1000;
+      if (v < 0)
+        v = 0;
+      x += vehicle_div_round((v0 + v) / 2 * h, 1000);
+    } else if (in->method == VEHICLE_EULER) {
+      a = vehicle_q_accel(p, in, drag, throttle, x, v);
+      x += vehicle_div_round(v * h, 1000);
+      v += vehicle_div_round(a * h, 1000);
+    } else if (in->method == VEHICLE_SEMI_IMPLICIT) {
+      a = vehicle_q_accel(p, in, drag, throttle, x, v);
+      v += vehicle_div_round(a * h, 1000);
+      x += vehicle_div_round(v * h, 1000);
+    } else {
+      kx[0] = v;
+      k[0]  = vehicle_q_accel(p, in, drag, throttle, x, v);
+      kx[1] = v + vehicle_div_round(k[0] * h, 2000);
+      k[1]  = vehicle_q_accel(p, in, drag, throttle,
+                              x + vehicle_div_round(kx[0] * h, 2000), kx[1]);
+      kx[2] = v + vehicle_div_round(k[1] * h, 2000);
+      k[2]  = vehicle_q_accel(p, in, drag, throttle,
+                              x + vehicle_div_round(kx[1] * h, 2000), kx[2]);
+      kx[3] = v + vehicle_div_round(k[2] * h, 1000);
+      k[3]  = vehicle_q_accel(p, in, drag, throttle,
+                              x + vehicle_div_round(kx[2] * h, 1000), kx[3]);
+      x += vehicle_div_round((kx[0] + 2 * (kx[1] + kx[2]) + kx[3]) / 6 * h,
+                             1000);
+      v += vehicle_div_round((k[0] + 2 * (k[1] + k[2]) + k[3]) / 6 * h, 1000);
+    }
+    if ((v0 > 0 && v < 0) || (v0 < 0 && v > 0))
+      v = 0;
+    p->position = vehicle_q_wrap(x);
+    p->velocity = v;
+  }
+}
+
+/*
+ * The function 'adjust_velocity()' adjusts the velocity depending on the
+ * acceleration.
+ */
+INT16S adjust_velocity(INT16S velocity, INT8S acceleration,
+		       enum active brake_pedal, INT16U time_interval)
+{
+#if CRUISE_FIXED_POINT
+  INT16S new_velocity;
+  INT8U brake_retardation = 200;
+
+  if (brake_pedal == off)
+    /*
+     * Integer division truncates toward zero like the conversion of the
+     * float sum, so the result is the same as the float version's.
+     */
+    new_velocity = ((INT32S) velocity * 1000
+                    + (INT32S) acceleration * time_interval) / 1000;
+  else {
+    if (brake_retardation * time_interval / 1000 > velocity)
+      new_velocity = 0;
+    else
+      new_velocity = velocity - brake_retardation * time_interval / 1000;
+  }
+
+  return new_velocity;
+#else
+  return adjust_velocity_float(velocity, acceleration, brake_pedal,
+                               time_interval);
+#endif
+}
@@ -0,0 +1,115 @@
+/*
+ * Vehicle model: position and velocity update of the plant
+ */
+#ifndef VEHICLE_H_
+#define VEHICLE_H_
+
+#include "includes.h"
+#include "cruise_config.h"
+
+enum active {on, off};
+
+INT32U adjust_position(INT32U position, INT16S velocity,
+                       INT8S acceleration, INT16U time_interval);
+INT16S adjust_velocity(INT16S velocity, INT8S acceleration,
+                       enum active brake_pedal, INT16U time_interval);
+
+/*
+ * Plant state for updates over any interval: the position and the
+ * velocity keep their fractions, in 1/1000 of a unit with the sign of the
+ * motion, from one update to the next, so short intervals do not truncate
+ * the motion away
+ */
+struct vehicle_plant {
+  INT32U position;              /* 0.1 m, 0 to track_length */
+  INT16S velocity;              /* 0.1 m/s */
+  INT16S position_frac;
+  INT16S velocity_frac;
+};
+
+/* The vehicle stands still, fractions included */
+#define VEHICLE_AT_REST(p) ((p)->velocity == 0 && (p)->velocity_frac == 0)
+
+void vehicle_plant_step(struct vehicle_plant *p, INT8S acceleration,
+                        enum active brake_pedal, INT16U time_interval);
+
+/*
+ * Retardation of the vehicle besides the slope: the wind factor
+ * velocity^2 / wind_div and the rolling resistance, in 0.1 m/s^2
+ */
+struct vehicle_drag {
+  INT16U wind_div;
+  INT8S  rolling;
+};
+
+#define VEHICLE_WIND_DIV 10000
+#define VEHICLE_ROLLING  1
+
+/* Acceleration [0.1 m/s^2] at 'throttle' [0.1 V] on a 'slope' */
+INT8S vehicle_acceleration(const struct vehicle_plant *p, INT8U throttle,
+                           INT8S slope);
+/* The same with another drag, e.g. of the host simulations */
+INT8S vehicle_acceleration_drag(const struct vehicle_plant *p, INT8U throttle,
+                                INT8S slope, const struct vehicle_drag *drag);
+
+/*
+ * Throttle [0.1 V, 0 to 80] that holds 'velocity' [0.1 m/s, >= 0] on a
+ * 'slope': twice the retardation vehicle_acceleration() subtracts, so the
+ * acceleration is 0 where the throttle does not saturate
+ */
+INT8U vehicle_feedforward(INT16S velocity, INT8S slope);
+
+/*
+ * Integrator of the plant with the state in Q-format: position and
+ * velocity in 0.1 m and 0.1 m/s with VEHICLE_Q_BITS fraction bits.  Each
+ * call integrates 'time_interval' ms in 'substeps' equal sub-steps by
+ * explicit Euler, semi-implicit Euler (the velocity first, then the
+ * position with the new velocity) or classic RK4.  The acceleration is
+ * evaluated at the state of each stage, with the throttle held over the
+ * call, so the integrator takes the throttle and not an acceleration.
+ * Unlike vehicle_acceleration() the throttle is not halved in integers.
+ * The rules of vehicle_plant_step() hold: the rolling resistance holds a
+ * vehicle at rest and the velocity does not change its sign within a
+ * sub-step.  A sub-step may be at most 10 s long.
+ */
+#define VEHICLE_Q_BITS 8
+#define VEHICLE_Q_ONE  (1L << VEHICLE_Q_BITS)
+
+enum vehicle_method {
+  VEHICLE_EULER,
+  VEHICLE_SEMI_IMPLICIT,
+  VEHICLE_RK4
+};
+
+struct vehicle_q {
+  INT32S position;              /* 0.1 m Q8, 0 to track_length */
+  INT32S velocity;              /* 0.1 m/s Q8 */
+  INT16U segment;               /* Of the last track lookup */
+};
+
+struct vehicle_integrator {
+  enum vehicle_method        method;
+  INT8U                      substeps;
+  const struct vehicle_drag *drag;      /* NULL: the drag of the board */
+  const INT8S               *slope;     /* Of each segment, NULL: the track */
+};
+
+/* Whole units of the state, rounded toward zero */
+#define VEHICLE_Q_POSITION(p) ((INT32U) ((p)->position >> VEHICLE_Q_BITS))
+#define VEHICLE_Q_VELOCITY(p) ((INT16S) ((p)->velocity < 0 ? \
+    -(-(p)->velocity >> VEHICLE_Q_BITS) : (p)->velocity >> VEHICLE_Q_BITS))
+
+void vehicle_integrate(struct vehicle_q *p, const struct vehicle_integrator *in,
+                       INT8U throttle, enum active brake_pedal,
+                       INT16U time_interval);
+
+#if CRUISE_FLOAT_REFERENCE
+INT16S adjust_velocity_float(INT16S velocity, INT8S acceleration,
+                             enum active brake_pedal, INT16U time_interval);
+/* vehicle_plant_step() in float, the one CRUISE_FIXED_POINT=0 selects */
+void   vehicle_plant_step_float(struct vehicle_plant *p, INT8S acceleration,
+                                enum active brake_pedal,
+                                INT16U time_interval);
+#endif
+
+#endif /* VEHICLE_H_ */
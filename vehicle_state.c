@@ -0,0 +1,33 @@
+#include "vehicle_state.h"
+#include "seqlock.h"
+
+static SEQLOCK(struct vehicle_state) vehicle_state_blk;
+static SEQLOCK(struct control_state) control_state_blk = {
+  0, { { 0, off, 0, off }, { 0, off, 0, off } }
+};
+
+/* Written by VehicleTask only */
+void vehicle_state_publish(struct vehicle_state *s)
+{
+  s->time = OSTimeGet();
+  s->seq  = vehicle_state_blk.seq / 2 + 1;
+  SEQLOCK_WRITE(&vehicle_state_blk, *s);
+}
+
+/* Written by ControlTask only */
+void control_state_publish(struct control_state *s)
+{
+  s->time = OSTimeGet();
+  s->seq  = control_state_blk.seq / 2 + 1;
+  SEQLOCK_WRITE(&control_state_blk, *s);
+}
+
+void vehicle_state_read(struct vehicle_state *s)
+{
+  SEQLOCK_READ(&vehicle_state_blk, *s);
+}
+
+void control_state_read(struct control_state *s)
+{
+  SEQLOCK_READ(&control_state_blk, *s);
+}
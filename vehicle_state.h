@@ -0,0 +1,38 @@
+/*
+ * Shared state of the vehicle and the controller
+ *
+ * VehicleTask publishes the vehicle state and ControlTask the controller
+ * output after each cycle.  Any task can read a consistent copy of either
+ * without blocking (seqlock.h).
+ */
+#ifndef VEHICLE_STATE_H_
+#define VEHICLE_STATE_H_
+
+#include "includes.h"
+#include "vehicle.h"
+
+struct vehicle_state {
+  INT16S velocity;      /* 0.1 m/s */
+  INT32U position;      /* 0.1 m */
+  INT8U  throttle;      /* 0.1 V, applied in the last step */
+  INT32U time;          /* OS tick of the update */
+  INT32U seq;           /* Number of updates */
+};
+
+struct control_state {
+  INT8U       throttle;         /* 0.1 V */
+  enum active cruise_control;
+  INT16U      target_velocity;  /* 0.1 m/s */
+  enum active brake_pedal;      /* As of the cycle, for VehicleTask */
+  INT32U      time;             /* OS tick of the update */
+  INT32U      seq;              /* Number of updates */
+};
+
+/* Writers: fill in the values, time and seq are set here */
+void vehicle_state_publish(struct vehicle_state *s);
+void control_state_publish(struct control_state *s);
+
+void vehicle_state_read(struct vehicle_state *s);
+void control_state_read(struct control_state *s);
+
+#endif /* VEHICLE_STATE_H_ */